@@ -0,0 +1,273 @@
+/**
+ * Benchmark of the revelation21 actions on the native chain.
+ *
+ * Drives synthetic holders through open, bulk onboarding, UBI claims, transfers, accrued balance
+ *   queries, close and maintenance sweeps (including the migration of rows left by the "extras"
+ *   layout), and reports for every action: throughput, DB reads/writes, notifications, inline
+ *   actions and action data bytes per call, followed by the size of the contract state and an
+ *   audit of the balances against the supply.
+ *
+ *   revelation21_bench [--holders N] [--transfers N] [--days N] [--batch N] [--seed N] [--metrics N]
+ *
+ * --metrics keeps N days of metrics (see token::setmetrics()), to compare the cost of the actions
+ *   with and without them.
+ */
+
+#include "token_driver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace eosio;
+using revelation21::token_driver;
+
+namespace {
+
+struct options {
+    uint32_t holders   = 20000;
+    uint32_t transfers = 1000000;
+    uint32_t days      = 30;
+    uint32_t batch     = 100;
+    uint64_t seed      = 21;
+    uint32_t metrics   = 0;
+};
+
+options parse_options( int argc, char** argv ) {
+    options o;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* arg = argv[i];
+        const uint64_t value = std::strtoull( argv[i + 1], nullptr, 10 );
+        if (!std::strcmp( arg, "--holders" ))
+            o.holders = value;
+        else if (!std::strcmp( arg, "--transfers" ))
+            o.transfers = value;
+        else if (!std::strcmp( arg, "--days" ))
+            o.days = value;
+        else if (!std::strcmp( arg, "--batch" ))
+            o.batch = value;
+        else if (!std::strcmp( arg, "--seed" ))
+            o.seed = value;
+        else if (!std::strcmp( arg, "--metrics" ))
+            o.metrics = value;
+        else {
+            std::fprintf( stderr, "unknown option %s\n", arg );
+            std::exit( 1 );
+        }
+    }
+    return o;
+}
+
+// Holder number i as a valid account name; three out of four end with ".jc" and can claim UBI.
+name holder_name( uint32_t i ) {
+    static const char* charmap = "abcdefghijklmnopqrstuvwxyz12345";
+    std::string s = "h";
+    for (int d = 0; d < 6; ++d) {
+        s.push_back( charmap[i % 31] );
+        i /= 31;
+    }
+    return name( s );
+}
+
+struct holder {
+    name account;
+    bool ubi;
+};
+
+// Runs one phase of the benchmark and prints the cost of every action it pushed.
+template <typename F>
+void run_phase( native::chain& c, const char* phase, F&& f ) {
+    c.reset_stats();
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    native::action_stats total;
+    for (const auto& s : c.stats) {
+        total.count          += s.second.count;
+        total.failed         += s.second.failed;
+        total.db_reads       += s.second.db_reads;
+        total.db_writes      += s.second.db_writes;
+        total.notifications  += s.second.notifications;
+        total.inline_actions += s.second.inline_actions;
+        total.data_bytes     += s.second.data_bytes;
+    }
+
+    const double n = total.count ? double(total.count) : 1.0;
+    std::printf( "%-9s %-10s %9llu %8llu %11.0f %7.2f %7.2f %7.2f %7.2f %7.1f\n",
+                 phase, "(all)", (unsigned long long)total.count, (unsigned long long)total.failed,
+                 seconds > 0 ? total.count / seconds : 0.0, total.db_reads / n, total.db_writes / n,
+                 total.notifications / n, total.inline_actions / n, total.data_bytes / n );
+    for (const auto& s : c.stats) {
+        const auto& st = s.second;
+        const double n = st.count ? double(st.count) : 1.0;
+        std::printf( "%-9s %-10s %9llu %8llu %11s %7.2f %7.2f %7.2f %7.2f %7.1f\n",
+                     "", name(s.first).to_string().c_str(), (unsigned long long)st.count, (unsigned long long)st.failed, "",
+                     st.db_reads / n, st.db_writes / n, st.notifications / n, st.inline_actions / n, st.data_bytes / n );
+    }
+}
+
+} /// namespace
+
+int main( int argc, char** argv ) {
+    const options opt = parse_options( argc, argv );
+
+    native::chain& c = native::chain::instance();
+    token_driver token( c );
+
+    const symbol heart( "HEART", 4 );
+    const int64_t unit = 10000;
+
+    c.set_day( 18047 + 1000 );
+    if (!token.create( token.contract(), asset{2100000000ll * unit, heart} )) {
+        std::fprintf( stderr, "create failed\n" );
+        return 1;
+    }
+    if (opt.metrics && !token.setmetrics( heart.code(), opt.metrics )) {
+        std::fprintf( stderr, "setmetrics failed\n" );
+        return 1;
+    }
+
+    std::mt19937_64 rng( opt.seed );
+    std::vector<holder> holders;
+    holders.reserve( opt.holders );
+    for (uint32_t i = 0; i < opt.holders; ++i) {
+        const bool ubi = (i % 4) != 3;
+        std::string base = holder_name( i ).to_string();
+        holders.push_back( holder{ name( ubi ? base + ".jc" : base ), ubi } );
+    }
+
+    std::printf( "%-9s %-10s %9s %8s %11s %7s %7s %7s %7s %7s\n",
+                 "phase", "action", "count", "failed", "actions/s", "reads", "writes", "notifs", "inlines", "bytes" );
+
+    // Every holder opens its balance; UBI holders claim their back pay on open.
+    run_phase( c, "open", [&]() {
+        for (const auto& h : holders)
+            token.open( h.account, heart, h.account );
+    });
+
+    // A sponsor onboards as many new UBI holders again, "batch" owners per openmany().
+    const uint32_t batch = opt.batch ? opt.batch : 1;
+    std::vector<name> onboarded;
+    onboarded.reserve( opt.holders );
+    for (uint32_t i = 0; i < opt.holders; ++i)
+        onboarded.push_back( name( "n" + holder_name( i ).to_string().substr( 1 ) + ".jc" ) );
+    std::sort( onboarded.begin(), onboarded.end() );
+    run_phase( c, "onboard", [&]() {
+        for (size_t i = 0; i < onboarded.size(); i += batch) {
+            const auto end = onboarded.begin() + std::min<size_t>( i + batch, onboarded.size() );
+            token.openmany( token.contract(), heart, 1, std::vector<name>( onboarded.begin() + i, end ) );
+        }
+    });
+
+    // One day later, every UBI holder claims through open() without transferring anything.
+    c.advance_days( 1 );
+    run_phase( c, "claim", [&]() {
+        for (const auto& h : holders) {
+            if (h.ubi)
+                token.open( h.account, heart, h.account );
+        }
+    });
+
+    // Random transfers, with the clock moving forward one day at a time so that senders claim.
+    run_phase( c, "transfer", [&]() {
+        const uint32_t per_day = opt.days ? opt.transfers / opt.days + 1 : opt.transfers + 1;
+        std::uniform_int_distribution<uint32_t> pick( 0, opt.holders - 1 );
+        for (uint32_t i = 0; i < opt.transfers; ++i) {
+            if (i % per_day == per_day - 1)
+                c.advance_days( 1 );
+            const holder& from = holders[pick( rng )];
+            const holder& to = holders[pick( rng )];
+            token.transfer( from.account, to.account, asset{1 + int64_t(rng() % unit), heart}, "" );
+        }
+    });
+
+    // Payroll: UBI holders pay batches of "batch" random holders with one transfermany() each.
+    run_phase( c, "payroll", [&]() {
+        const uint32_t batches = opt.batch ? opt.transfers / opt.batch / 10 : 0;
+        std::uniform_int_distribution<uint32_t> pick( 0, opt.holders - 1 );
+        std::vector<eosio::token::payment> payments( opt.batch );
+        for (uint32_t i = 0; i < batches; ++i) {
+            const holder& from = holders[(i * 4) % opt.holders];
+            for (auto& p : payments)
+                p = eosio::token::payment{ holders[pick( rng )].account, asset{1 + int64_t(rng() % unit), heart}, "" };
+            token.transfermany( from.account, payments );
+        }
+    });
+
+    // A wallet backend refreshes the accrued balance of every holder, "batch" holders per getaccrued().
+    c.advance_days( 1 );
+    run_phase( c, "query", [&]() {
+        std::vector<eosio::token::balance_query> queries;
+        queries.reserve( opt.batch );
+        for (uint32_t i = 0; i < opt.holders; ++i) {
+            queries.push_back( eosio::token::balance_query{ holders[i].account, heart.code() } );
+            if (queries.size() == opt.batch || i + 1 == opt.holders) {
+                token.getaccrued( queries );
+                queries.clear();
+            }
+        }
+    });
+
+    // Every holder that cannot claim UBI empties its balance and closes it.
+    run_phase( c, "close", [&]() {
+        const name sink = holders[0].account;
+        for (const auto& h : holders) {
+            if (h.ubi)
+                continue;
+            const asset balance = token.balance( h.account, heart );
+            if (balance.amount > 0)
+                token.transfer( h.account, sink, balance, "" );
+            token.close( h.account, heart );
+        }
+    });
+
+    // One UBI holder in ten still has the rows of the "extras" layout, paid for by itself, as left by an
+    //   upgrade of the contract.
+    std::vector<name> legacy;
+    for (uint32_t i = 0; i < opt.holders / 10; ++i) {
+        legacy.push_back( name( "l" + holder_name( i ).to_string().substr( 1 ) + ".jc" ) );
+        token.seed_legacy( legacy.back(), asset{0, heart}, legacy.back(), eosio::token::time_type( c.day() - 1 - i % 30 ) );
+    }
+
+    // A keeper sweeps every scope with the cleanup pass and the migrate pass, then compacts the supply
+    //   shards and audits every scope, "batch" owners at a time.
+    std::vector<name> scopes = onboarded;
+    for (const auto& h : holders)
+        scopes.push_back( h.account );
+    scopes.insert( scopes.end(), legacy.begin(), legacy.end() );
+    std::sort( scopes.begin(), scopes.end() );
+    run_phase( c, "maintain", [&]() {
+        for (uint8_t pass : { eosio::token::cleanup_pass, eosio::token::migrate_pass, eosio::token::audit_pass }) {
+            for (size_t i = 0; i < scopes.size(); i += batch) {
+                const auto end = scopes.begin() + std::min<size_t>( i + batch, scopes.size() );
+                c.console.clear();
+                c.console_enabled = true;
+                token.maintain( heart.code(), pass, i == 0, std::vector<name>( scopes.begin() + i, end ), 4 * batch );
+                c.console_enabled = false;
+            }
+            if (pass == eosio::token::migrate_pass)
+                token.compact( heart.code() );
+        }
+    });
+
+    std::printf( "\naudit: %s\n", c.console.c_str() );
+    std::printf( "state: %zu rows in %zu tables, %lld bytes of rows, %lld bytes of billable RAM\n",
+                 c.db.row_count(), c.db.table_count(), (long long)c.db.row_bytes(), (long long)c.db.ram_bytes );
+    std::printf( "supply: %s\n", token.supply( heart ).to_string().c_str() );
+    const auto liability = token.liability( heart );
+    std::printf( "UBI liability: %llu accounts, %s unclaimed, %s projected supply\n", (unsigned long long)liability.ubi_accounts,
+                 liability.unclaimed.to_string().c_str(), liability.projected_supply.to_string().c_str() );
+    for (const auto& m : token.metrics( heart )) {
+        std::printf( "metrics: day %u: %llu transfers of %lld, %llu claims of %lld, %llu lost days, %llu opened, %llu closed\n",
+                     unsigned(m.day), (unsigned long long)m.transfers, (long long)m.transfer_volume, (unsigned long long)m.claims,
+                     (long long)m.minted, (unsigned long long)m.lost_days, (unsigned long long)m.new_holders,
+                     (unsigned long long)m.closed_holders );
+    }
+    return 0;
+}
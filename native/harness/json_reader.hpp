@@ -0,0 +1,248 @@
+/**
+ * Minimal JSON reader for the native tools, for the table dumps and traces written by cleos and
+ *   nodeos. Numbers are kept as text, since nodeos writes 64-bit integers either as numbers or
+ *   as strings; as_int() and as_uint() read both.
+ */
+#pragma once
+
+#include <eosiolib/asset.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/symbol.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace revelation21 { namespace json {
+
+    struct value {
+        enum kind_type { null, boolean, number, string, array, object };
+
+        kind_type                                   kind = null;
+        bool                                        flag = false;   // boolean
+        std::string                                 text;           // number or string
+        std::vector<value>                          items;          // array
+        std::vector<std::pair<std::string, value>>  members;        // object, in document order
+
+        // The member "key" of an object, or nullptr if there is none.
+        const value* find( std::string_view key )const {
+            for (const auto& m : members)
+                if (m.first == key)
+                    return &m.second;
+            return nullptr;
+        }
+
+        const value& operator[]( std::string_view key )const {
+            const value* v = find( key );
+            if (!v)
+                throw std::runtime_error( "json: missing member \"" + std::string( key ) + "\"" );
+            return *v;
+        }
+
+        int64_t as_int()const {
+            return static_cast<int64_t>( parse_integer( true ) );
+        }
+
+        uint64_t as_uint()const {
+            return parse_integer( false );
+        }
+
+        const std::string& as_string()const {
+            if (kind != string)
+                throw std::runtime_error( "json: not a string" );
+            return text;
+        }
+
+        private:
+            uint64_t parse_integer( bool is_signed )const {
+                if (kind != number && kind != string)
+                    throw std::runtime_error( "json: not an integer" );
+                char* end = nullptr;
+                errno = 0;
+                const uint64_t v = is_signed ? uint64_t( std::strtoll( text.c_str(), &end, 10 ) )
+                                             : std::strtoull( text.c_str(), &end, 10 );
+                if (text.empty() || *end || errno)
+                    throw std::runtime_error( "json: not an integer: " + text );
+                return v;
+            }
+    };
+
+    class reader {
+        public:
+            explicit reader( std::string_view text ) : _text(text) {}
+
+            value parse() {
+                value v = parse_value();
+                skip_space();
+                if (_pos != _text.size())
+                    fail( "trailing characters" );
+                return v;
+            }
+
+        private:
+            [[noreturn]] void fail( const char* what )const {
+                throw std::runtime_error( std::string( "json: " ) + what + " at offset " + std::to_string( _pos ) );
+            }
+
+            void skip_space() {
+                while (_pos < _text.size() && (_text[_pos] == ' ' || _text[_pos] == '\t' || _text[_pos] == '\n' || _text[_pos] == '\r'))
+                    ++_pos;
+            }
+
+            bool consume( std::string_view token ) {
+                if (_text.compare( _pos, token.size(), token ) != 0)
+                    return false;
+                _pos += token.size();
+                return true;
+            }
+
+            void expect( char c ) {
+                skip_space();
+                if (_pos >= _text.size() || _text[_pos] != c)
+                    fail( "unexpected character" );
+                ++_pos;
+            }
+
+            value parse_value() {
+                skip_space();
+                if (_pos >= _text.size())
+                    fail( "unexpected end" );
+                value v;
+                const char c = _text[_pos];
+                if (c == '{') {
+                    v.kind = value::object;
+                    ++_pos;
+                    skip_space();
+                    if (consume( "}" ))
+                        return v;
+                    do {
+                        skip_space();
+                        std::string key = parse_string();
+                        expect( ':' );
+                        v.members.emplace_back( std::move( key ), parse_value() );
+                        skip_space();
+                    } while (consume( "," ));
+                    expect( '}' );
+                } else if (c == '[') {
+                    v.kind = value::array;
+                    ++_pos;
+                    skip_space();
+                    if (consume( "]" ))
+                        return v;
+                    do {
+                        v.items.push_back( parse_value() );
+                        skip_space();
+                    } while (consume( "," ));
+                    expect( ']' );
+                } else if (c == '"') {
+                    v.kind = value::string;
+                    v.text = parse_string();
+                } else if (consume( "true" )) {
+                    v.kind = value::boolean;
+                    v.flag = true;
+                } else if (consume( "false" )) {
+                    v.kind = value::boolean;
+                } else if (consume( "null" )) {
+                } else if (c == '-' || (c >= '0' && c <= '9')) {
+                    v.kind = value::number;
+                    const size_t begin = _pos++;
+                    while (_pos < _text.size() && std::string_view( "0123456789+-.eE" ).find( _text[_pos] ) != std::string_view::npos)
+                        ++_pos;
+                    v.text = std::string( _text.substr( begin, _pos - begin ) );
+                } else {
+                    fail( "unexpected character" );
+                }
+                return v;
+            }
+
+            std::string parse_string() {
+                if (_pos >= _text.size() || _text[_pos] != '"')
+                    fail( "expected a string" );
+                ++_pos;
+                std::string s;
+                while (true) {
+                    if (_pos >= _text.size())
+                        fail( "unterminated string" );
+                    const char c = _text[_pos++];
+                    if (c == '"')
+                        return s;
+                    if (c != '\\') {
+                        s.push_back( c );
+                        continue;
+                    }
+                    if (_pos >= _text.size())
+                        fail( "unterminated string" );
+                    const char e = _text[_pos++];
+                    switch (e) {
+                        case 'b': s.push_back( '\b' ); break;
+                        case 'f': s.push_back( '\f' ); break;
+                        case 'n': s.push_back( '\n' ); break;
+                        case 'r': s.push_back( '\r' ); break;
+                        case 't': s.push_back( '\t' ); break;
+                        case 'u': {
+                            if (_pos + 4 > _text.size())
+                                fail( "bad escape" );
+                            const uint32_t cp = std::strtoul( std::string( _text.substr( _pos, 4 ) ).c_str(), nullptr, 16 );
+                            _pos += 4;
+                            // Code points of the basic plane only, as UTF-8; the dumps are names and memos.
+                            if (cp < 0x80) {
+                                s.push_back( char(cp) );
+                            } else if (cp < 0x800) {
+                                s.push_back( char(0xC0 | (cp >> 6)) );
+                                s.push_back( char(0x80 | (cp & 0x3F)) );
+                            } else {
+                                s.push_back( char(0xE0 | (cp >> 12)) );
+                                s.push_back( char(0x80 | ((cp >> 6) & 0x3F)) );
+                                s.push_back( char(0x80 | (cp & 0x3F)) );
+                            }
+                            break;
+                        }
+                        default: s.push_back( e ); break;
+                    }
+                }
+            }
+
+            std::string_view _text;
+            size_t           _pos = 0;
+    };
+
+    inline value parse( std::string_view text ) {
+        return reader( text ).parse();
+    }
+
+    // eosio values, as nodeos writes them.
+    inline eosio::name to_name( const value& v ) {
+        return eosio::name( v.as_string() );
+    }
+
+    // "4,HEART"
+    inline eosio::symbol to_symbol( const value& v ) {
+        const std::string& s = v.as_string();
+        const size_t comma = s.find( ',' );
+        if (comma == std::string::npos)
+            throw std::runtime_error( "json: not a symbol: " + s );
+        return eosio::symbol( std::string_view( s ).substr( comma + 1 ), uint8_t( std::stoul( s.substr( 0, comma ) ) ) );
+    }
+
+    // "12.3456 HEART"
+    inline eosio::asset to_asset( const value& v ) {
+        const std::string& s = v.as_string();
+        const size_t space = s.find( ' ' );
+        if (space == std::string::npos)
+            throw std::runtime_error( "json: not an asset: " + s );
+        std::string digits = s.substr( 0, space );
+        const size_t dot = digits.find( '.' );
+        uint8_t precision = 0;
+        if (dot != std::string::npos) {
+            precision = uint8_t( digits.size() - dot - 1 );
+            digits.erase( dot, 1 );
+        }
+        return eosio::asset{ std::stoll( digits ), eosio::symbol( std::string_view( s ).substr( space + 1 ), precision ) };
+    }
+
+}} /// namespace revelation21::json
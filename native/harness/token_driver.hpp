@@ -0,0 +1,168 @@
+/**
+ * Typed front end for pushing revelation21 actions to the native chain and reading its state,
+ *   shared by the native tools (benchmark, ...).
+ */
+#pragma once
+
+#include <eosiolib/native/chain.hpp>
+
+#include "revelation21.hpp"
+
+#include <string>
+#include <vector>
+
+namespace revelation21 {
+
+    using eosio::asset;
+    using eosio::name;
+    using eosio::symbol;
+    using eosio::symbol_code;
+    using eosio::native::push_result;
+
+    class token_driver {
+        public:
+            explicit token_driver( eosio::native::chain& c = eosio::native::chain::instance(), name contract = "revelation21"_n )
+            : _chain(c), _contract(contract) {
+                _chain.set_code<eosio::token>( _contract );
+            }
+
+            eosio::native::chain& chain() { return _chain; }
+
+            name contract()const { return _contract; }
+
+            push_result create( name issuer, asset maximum_supply ) {
+                return push( "create"_n, _contract, issuer, maximum_supply );
+            }
+
+            push_result issue( name to, asset quantity, const std::string& memo ) {
+                return push( "issue"_n, _contract, to, quantity, memo );
+            }
+
+            push_result retire( name issuer, asset quantity, const std::string& memo ) {
+                return push( "retire"_n, issuer, quantity, memo );
+            }
+
+            push_result transfer( name from, name to, asset quantity, const std::string& memo ) {
+                return push( "transfer"_n, from, from, to, quantity, memo );
+            }
+
+            push_result transfermany( name from, const std::vector<eosio::token::payment>& payments ) {
+                return push( "transfermany"_n, from, from, payments );
+            }
+
+            push_result open( name owner, symbol sym, name ram_payer ) {
+                return push( "open"_n, ram_payer, owner, sym, ram_payer );
+            }
+
+            push_result openmany( name sponsor, symbol sym, uint64_t wave, const std::vector<name>& owners ) {
+                return push( "openmany"_n, sponsor, sponsor, sym, wave, owners );
+            }
+
+            push_result close( name owner, symbol sym ) {
+                return push( "close"_n, owner, owner, sym );
+            }
+
+            push_result migrate( symbol_code sym, const std::vector<name>& owners ) {
+                return push( "migrate"_n, _contract, sym, owners );
+            }
+
+            push_result maintain( symbol_code sym, uint8_t pass, bool restart, const std::vector<name>& owners, uint32_t max_rows ) {
+                return push( "maintain"_n, _contract, sym, pass, restart, owners, max_rows );
+            }
+
+            push_result compact( symbol_code sym ) {
+                return push( "compact"_n, _contract, sym );
+            }
+
+            push_result setelig( name account, uint8_t status ) {
+                return push( "setelig"_n, _contract, account, status );
+            }
+
+            push_result setnotify( name account, symbol_code sym, uint8_t mode ) {
+                return push( "setnotify"_n, account, account, sym, mode );
+            }
+
+            push_result getaccrued( const std::vector<eosio::token::balance_query>& queries ) {
+                return _chain.push_action( _contract, "getaccrued"_n, {}, queries );
+            }
+
+            push_result setmetrics( symbol_code sym, uint16_t days ) {
+                return push( "setmetrics"_n, _contract, sym, days );
+            }
+
+            push_result getdormant( symbol_code sym, uint16_t from_day, uint16_t to_day, uint32_t limit ) {
+                return _chain.push_action( _contract, "getdormant"_n, {}, sym, from_day, to_day, limit );
+            }
+
+            // Balance of "owner", or a zero balance if it has no balance row.
+            asset balance( name owner, symbol sym ) {
+                return _chain.peek( [&]() {
+                    try {
+                        return eosio::token::get_balance( _contract, owner, sym.code() );
+                    } catch (const eosio::native::eosio_assert_exception&) {
+                        return asset{0, sym};
+                    }
+                });
+            }
+
+            eosio::token::accrued_balance accrued( name owner, symbol sym ) {
+                return _chain.peek( [&]() { return eosio::token::get_accrued_balance( _contract, owner, sym.code() ); } );
+            }
+
+            std::vector<eosio::token::dormant_account> dormant( symbol sym, uint16_t from_day, uint16_t to_day, uint32_t limit ) {
+                return _chain.peek( [&]() { return eosio::token::get_dormant( _contract, sym.code(), from_day, to_day, limit ); } );
+            }
+
+            std::vector<eosio::token::daily_metrics> metrics( symbol sym ) {
+                return _chain.peek( [&]() { return eosio::token::get_metrics( _contract, sym.code() ); } );
+            }
+
+            eosio::token::ubi_liability liability( symbol sym ) {
+                return _chain.peek( [&]() { return eosio::token::get_ubi_liability( _contract, sym.code() ); } );
+            }
+
+            asset supply( symbol sym ) {
+                return _chain.peek( [&]() { return eosio::token::get_supply( _contract, sym.code() ); } );
+            }
+
+            // The supply of the stat row alone, as "cleos get currency stats" shows it: without what the
+            //   supply shards have minted since the last compact().
+            asset stat_supply( symbol sym ) {
+                return _chain.run_as( _contract, {}, [&]() {
+                    eosio::token::stat_table stats( _contract, sym.code().raw() );
+                    return stats.get( sym.code().raw() ).supply;
+                });
+            }
+
+            // Writes a balance row as the contract wrote it before the "extras" table was merged into "accounts":
+            //   without a claim day, which is kept in an "extras" row instead (unless "claim_day" is 0). Without
+            //   "balance_row", only the extras row is written, as an orphan. Both rows are billed to "payer".
+            void seed_legacy( name owner, asset balance, name payer, eosio::token::time_type claim_day, bool balance_row = true ) {
+                _chain.run_as( _contract, { {payer, "active"_n} }, [&]() {
+                    if (balance_row) {
+                        eosio::token::balance_table acnts( _contract, owner.value );
+                        acnts.emplace( payer, [&]( auto& a ) {
+                            a.balance = balance;
+                        });
+                    }
+                    if (claim_day != 0) {
+                        eosio::token::legacy_extras_table xtrs( _contract, owner.value );
+                        xtrs.emplace( payer, [&]( auto& x ) {
+                            x.symbol_code_raw = balance.symbol.code().raw();
+                            x.last_claim_day = claim_day;
+                        });
+                    }
+                });
+            }
+
+        private:
+            template <typename... Args>
+            push_result push( name act, name actor, const Args&... args ) {
+                return _chain.push_action( _contract, act, { {actor, "active"_n} }, args... );
+            }
+
+            eosio::native::chain& _chain;
+            name                  _contract;
+    };
+
+} /// namespace revelation21
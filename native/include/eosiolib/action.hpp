@@ -0,0 +1,104 @@
+/**
+ * Native stand-in for eosiolib/action.hpp. Inline actions are queued on the native chain and
+ *   run after the sending action, like on nodeos.
+ */
+#pragma once
+
+#include <eosiolib/system.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/datastream.hpp>
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+extern "C" {
+
+    void require_auth( uint64_t name );
+
+    bool has_auth( uint64_t name );
+
+    void require_recipient( uint64_t name );
+
+    bool is_account( uint64_t name );
+
+}
+
+namespace eosio {
+
+    struct permission_level {
+        name actor;
+        name permission;
+
+        friend constexpr bool operator == ( const permission_level& a, const permission_level& b ) {
+            return a.actor == b.actor && a.permission == b.permission;
+        }
+    };
+
+    struct action;
+
+    namespace native {
+        void send_inline( const action& act );
+    }
+
+    struct action {
+        eosio::name                     account;
+        eosio::name                     name;
+        std::vector<permission_level>   authorization;
+        std::vector<char>               data;
+
+        action() = default;
+
+        template <typename T>
+        action( const permission_level& auth, struct name a, struct name n, T&& value )
+        :account(a), name(n), authorization(1,auth), data(pack(std::forward<T>(value))) {}
+
+        template <typename T>
+        action( std::vector<permission_level> auths, struct name a, struct name n, T&& value )
+        :account(a), name(n), authorization(std::move(auths)), data(pack(std::forward<T>(value))) {}
+
+        void send()const {
+            native::send_inline( *this );
+        }
+
+        template <typename T>
+        T data_as() {
+            return unpack<T>( data );
+        }
+    };
+
+    inline void require_auth( name n ) { ::require_auth( n.value ); }
+
+    inline bool has_auth( name n ) { return ::has_auth( n.value ); }
+
+    inline bool is_account( name n ) { return ::is_account( n.value ); }
+
+    inline void require_recipient( name notify_account ) {
+        ::require_recipient( notify_account.value );
+    }
+
+    template <typename... accounts>
+    void require_recipient( name notify_account, accounts... remaining_accounts ) {
+        ::require_recipient( notify_account.value );
+        require_recipient( remaining_accounts... );
+    }
+
+    template <typename, name::raw>
+    struct inline_dispatcher;
+
+    template <typename T, name::raw Name, typename... Args>
+    struct inline_dispatcher<void(T::*)(Args...), Name> {
+        static void call( name code, std::vector<permission_level> perms, std::tuple<std::decay_t<Args>...> args ) {
+            action( std::move(perms), code, name(Name), std::move(args) ).send();
+        }
+    };
+
+} /// namespace eosio
+
+#define INLINE_ACTION_SENDER( CONTRACT_CLASS, NAME )\
+::eosio::inline_dispatcher<decltype(&CONTRACT_CLASS::NAME), ::eosio::name(#NAME)>::call
+
+#define SEND_INLINE_ACTION( CONTRACT, NAME, ... )\
+INLINE_ACTION_SENDER(std::decay_t<decltype(CONTRACT)>, NAME)( (CONTRACT).get_self(), __VA_ARGS__ );
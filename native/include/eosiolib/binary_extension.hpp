@@ -0,0 +1,66 @@
+/**
+ * Native stand-in for eosiolib/binary_extension.hpp.
+ *
+ * A field that may be missing at the end of a serialized struct. It is only packed when it
+ *   holds a value, and reads back empty from rows written before the field existed.
+ */
+#pragma once
+
+#include <eosiolib/system.hpp>
+
+#include <optional>
+#include <utility>
+
+namespace eosio {
+
+    template <typename T>
+    class binary_extension {
+        public:
+            using value_type = T;
+
+            constexpr binary_extension() {}
+
+            constexpr binary_extension( const T& ext ) : _value(ext) {}
+
+            constexpr binary_extension( T&& ext ) : _value(std::move(ext)) {}
+
+            constexpr bool has_value()const { return _value.has_value(); }
+
+            constexpr T& value() & {
+                eosio_assert( _value.has_value(), "cannot get value of empty binary_extension" );
+                return *_value;
+            }
+
+            constexpr const T& value()const & {
+                eosio_assert( _value.has_value(), "cannot get value of empty binary_extension" );
+                return *_value;
+            }
+
+            template <typename U>
+            constexpr T value_or( U&& def )const {
+                return _value.has_value() ? *_value : static_cast<T>(std::forward<U>(def));
+            }
+
+            constexpr T value_or()const { return _value.has_value() ? *_value : T{}; }
+
+            constexpr T* operator->() { return &value(); }
+
+            constexpr const T* operator->()const { return &value(); }
+
+            constexpr T& operator*() & { return value(); }
+
+            constexpr const T& operator*()const & { return value(); }
+
+            template <typename... Args>
+            T& emplace( Args&&... args ) {
+                _value.emplace( std::forward<Args>(args)... );
+                return *_value;
+            }
+
+            void reset() { _value.reset(); }
+
+        private:
+            std::optional<T> _value;
+    };
+
+} /// namespace eosio
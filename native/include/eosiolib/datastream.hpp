@@ -0,0 +1,291 @@
+/**
+ * Native stand-in for eosiolib/datastream.hpp. Same wire format as the chain serializer.
+ */
+#pragma once
+
+#include <eosiolib/system.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/symbol.hpp>
+#include <eosiolib/asset.hpp>
+#include <eosiolib/binary_extension.hpp>
+#include <eosiolib/native/reflect.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace eosio {
+
+    template <typename T>
+    class datastream {
+        public:
+            datastream( T start, size_t s ) : _start(start), _pos(start), _end(start + s) {}
+
+            inline void skip( size_t s ) { _pos += s; }
+
+            inline bool read( char* d, size_t s ) {
+                eosio_assert( size_t(_end - _pos) >= s, "read" );
+                memcpy( d, _pos, s );
+                _pos += s;
+                return true;
+            }
+
+            inline bool write( const char* d, size_t s ) {
+                eosio_assert( _end - _pos >= (int32_t)s, "write" );
+                memcpy( (void*)_pos, d, s );
+                _pos += s;
+                return true;
+            }
+
+            inline T pos()const { return _pos; }
+
+            inline bool valid()const { return _pos <= _end && _pos >= _start; }
+
+            inline size_t tellp()const { return size_t(_pos - _start); }
+
+            inline size_t remaining()const { return _end - _pos; }
+
+        private:
+            T _start;
+            T _pos;
+            T _end;
+    };
+
+    // Counts the bytes that would be written, without writing them.
+    template <>
+    class datastream<size_t> {
+        public:
+            datastream( size_t init_size = 0 ) : _size(init_size) {}
+
+            inline bool skip( size_t s ) { _size += s; return true; }
+
+            inline bool write( const char*, size_t s ) { _size += s; return true; }
+
+            inline size_t tellp()const { return _size; }
+
+            inline size_t remaining()const { return 0; }
+
+        private:
+            size_t _size;
+    };
+
+    struct unsigned_int {
+        unsigned_int( uint32_t v = 0 ) : value(v) {}
+        uint32_t value;
+    };
+
+    template <typename Stream>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const unsigned_int& v ) {
+        uint64_t val = v.value;
+        do {
+            uint8_t b = uint8_t(val) & 0x7f;
+            val >>= 7;
+            b |= ((val > 0) << 7);
+            ds.write( (char*)&b, 1 );
+        } while( val );
+        return ds;
+    }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, unsigned_int& vi ) {
+        uint64_t v = 0; char b = 0; uint8_t by = 0;
+        do {
+            ds.read( &b, 1 );
+            v |= uint32_t(uint8_t(b) & 0x7f) << by;
+            by += 7;
+        } while( uint8_t(b) & 0x80 );
+        vi.value = static_cast<uint32_t>(v);
+        return ds;
+    }
+
+    // Fixed size scalars are written in their (little endian) memory layout.
+    template <typename Stream, typename T,
+              std::enable_if_t< std::is_arithmetic_v<T> || std::is_enum_v<T> >* = nullptr>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const T& v ) {
+        ds.write( (const char*)&v, sizeof(T) );
+        return ds;
+    }
+
+    template <typename Stream, typename T,
+              std::enable_if_t< std::is_arithmetic_v<T> || std::is_enum_v<T> >* = nullptr>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, T& v ) {
+        ds.read( (char*)&v, sizeof(T) );
+        return ds;
+    }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const name& v ) { return ds << v.value; }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, name& v ) { return ds >> v.value; }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const symbol_code& v ) { return ds << v.raw(); }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, symbol_code& v ) {
+        uint64_t raw = 0;
+        ds >> raw;
+        v = symbol_code(raw);
+        return ds;
+    }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const symbol& v ) { return ds << v.raw(); }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, symbol& v ) {
+        uint64_t raw = 0;
+        ds >> raw;
+        v = symbol(raw);
+        return ds;
+    }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const asset& v ) {
+        return ds << v.amount << v.symbol;
+    }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, asset& v ) {
+        return ds >> v.amount >> v.symbol;
+    }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const std::string& v ) {
+        ds << unsigned_int( v.size() );
+        if( v.size() )
+            ds.write( v.data(), v.size() );
+        return ds;
+    }
+
+    template <typename Stream>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, std::string& v ) {
+        unsigned_int s;
+        ds >> s;
+        v.resize( s.value );
+        if( s.value )
+            ds.read( &v[0], s.value );
+        return ds;
+    }
+
+    template <typename Stream, typename T>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const std::vector<T>& v ) {
+        ds << unsigned_int( v.size() );
+        for( const auto& i : v )
+            ds << i;
+        return ds;
+    }
+
+    template <typename Stream, typename T>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, std::vector<T>& v ) {
+        unsigned_int s;
+        ds >> s;
+        v.resize( s.value );
+        for( auto& i : v )
+            ds >> i;
+        return ds;
+    }
+
+    template <typename Stream, typename T>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const std::optional<T>& v ) {
+        ds << v.has_value();
+        if( v.has_value() )
+            ds << *v;
+        return ds;
+    }
+
+    template <typename Stream, typename T>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, std::optional<T>& v ) {
+        bool has = false;
+        ds >> has;
+        if( has ) {
+            T val;
+            ds >> val;
+            v = std::move(val);
+        } else {
+            v.reset();
+        }
+        return ds;
+    }
+
+    // Binary extensions are only written when present and only read when bytes are left.
+    template <typename Stream, typename T>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const binary_extension<T>& v ) {
+        if( v.has_value() )
+            ds << v.value();
+        return ds;
+    }
+
+    template <typename Stream, typename T>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, binary_extension<T>& v ) {
+        if( ds.remaining() ) {
+            T val;
+            ds >> val;
+            v.emplace( std::move(val) );
+        }
+        return ds;
+    }
+
+    template <typename Stream, typename... Args>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const std::tuple<Args...>& t ) {
+        std::apply( [&]( const auto&... a ) { ( (ds << a), ... ); }, t );
+        return ds;
+    }
+
+    template <typename Stream, typename... Args>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, std::tuple<Args...>& t ) {
+        std::apply( [&]( auto&... a ) { ( (ds >> a), ... ); }, t );
+        return ds;
+    }
+
+    // Plain structs (table rows, action arguments) are written field by field.
+    template <typename Stream, typename T,
+              std::enable_if_t< native::is_reflectable_v<T> >* = nullptr>
+    inline datastream<Stream>& operator<<( datastream<Stream>& ds, const T& v ) {
+        native::for_each_field( v, [&]( const auto& f ) { ds << f; } );
+        return ds;
+    }
+
+    template <typename Stream, typename T,
+              std::enable_if_t< native::is_reflectable_v<T> >* = nullptr>
+    inline datastream<Stream>& operator>>( datastream<Stream>& ds, T& v ) {
+        native::for_each_field( v, [&]( auto& f ) { ds >> f; } );
+        return ds;
+    }
+
+    template <typename T>
+    size_t pack_size( const T& value ) {
+        datastream<size_t> ps;
+        ps << value;
+        return ps.tellp();
+    }
+
+    template <typename T>
+    std::vector<char> pack( const T& value ) {
+        std::vector<char> result;
+        result.resize( pack_size( value ) );
+
+        datastream<char*> ds( result.data(), result.size() );
+        ds << value;
+        return result;
+    }
+
+    template <typename T>
+    T unpack( const char* buffer, size_t len ) {
+        T result;
+        datastream<const char*> ds( buffer, len );
+        ds >> result;
+        return result;
+    }
+
+    template <typename T>
+    T unpack( const std::vector<char>& bytes ) {
+        return unpack<T>( bytes.data(), bytes.size() );
+    }
+
+} /// namespace eosio
@@ -0,0 +1,77 @@
+/**
+ * Native stand-in for eosiolib/dispatcher.hpp.
+ *
+ * EOSIO_DISPATCH registers a handler per action of the contract class with the native chain,
+ *   instead of defining the wasm "apply" entry point. The action data is unpacked into the
+ *   arguments of the action method, exactly as the chain dispatcher does.
+ */
+#pragma once
+
+#include <eosiolib/name.hpp>
+#include <eosiolib/datastream.hpp>
+
+#include <map>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace eosio { namespace native {
+
+    typedef void (*action_handler)( name receiver, name code, const std::vector<char>& data );
+
+    // Actions of a contract class, by action name.
+    struct contract_abi {
+        std::map<uint64_t, action_handler> handlers;
+    };
+
+    template <typename Contract>
+    contract_abi& abi_of() {
+        static contract_abi abi;
+        return abi;
+    }
+
+    template <typename>
+    struct action_arguments;
+
+    template <typename T, typename... Args>
+    struct action_arguments<void(T::*)(Args...)> {
+        typedef std::tuple<std::decay_t<Args>...> type;
+    };
+
+    template <typename Contract, auto Action>
+    void execute_action( name receiver, name code, const std::vector<char>& data ) {
+        auto args = unpack< typename action_arguments<decltype(Action)>::type >( data );
+
+        Contract obj( receiver, code, datastream<const char*>( data.data(), data.size() ) );
+        std::apply( [&]( auto&... a ) { (obj.*Action)( a... ); }, args );
+    }
+
+    template <typename Contract>
+    struct dispatch_registrar {
+        dispatch_registrar& operator<<( std::pair<name, action_handler> a ) {
+            abi_of<Contract>().handlers[ a.first.value ] = a.second;
+            return *this;
+        }
+    };
+
+}} /// namespace eosio::native
+
+#define EOSIO_NATIVE_CAT( a, b ) EOSIO_NATIVE_CAT_I( a, b )
+#define EOSIO_NATIVE_CAT_I( a, b ) a ## b
+
+#define EOSIO_NATIVE_DISPATCH_ENTRY( MEMBER ) \
+   << std::make_pair( ::eosio::name( #MEMBER ), &::eosio::native::execute_action<eosio_native_contract, &eosio_native_contract::MEMBER> )
+
+// Walks a (a)(b)(c) sequence without Boost.Preprocessor.
+#define EOSIO_NATIVE_DISPATCH_A( MEMBER ) EOSIO_NATIVE_DISPATCH_ENTRY( MEMBER ) EOSIO_NATIVE_DISPATCH_B
+#define EOSIO_NATIVE_DISPATCH_B( MEMBER ) EOSIO_NATIVE_DISPATCH_ENTRY( MEMBER ) EOSIO_NATIVE_DISPATCH_A
+#define EOSIO_NATIVE_DISPATCH_A_END
+#define EOSIO_NATIVE_DISPATCH_B_END
+
+#define EOSIO_DISPATCH( TYPE, MEMBERS ) \
+namespace { \
+   using eosio_native_contract = TYPE; \
+   [[maybe_unused]] const bool eosio_native_dispatch = ( ::eosio::native::dispatch_registrar<eosio_native_contract>() \
+      EOSIO_NATIVE_CAT( EOSIO_NATIVE_DISPATCH_A MEMBERS, _END ), true ); \
+}
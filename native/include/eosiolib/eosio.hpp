@@ -0,0 +1,15 @@
+/**
+ * Native stand-in for eosiolib/eosio.hpp.
+ *
+ * Lets the contract sources build for the host against the in-memory chain of
+ *   eosiolib/native/chain.hpp. See native/README.md.
+ */
+#pragma once
+
+#include <eosiolib/system.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/action.hpp>
+#include <eosiolib/print.hpp>
+#include <eosiolib/multi_index.hpp>
+#include <eosiolib/dispatcher.hpp>
+#include <eosiolib/contract.hpp>
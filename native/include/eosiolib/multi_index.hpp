@@ -0,0 +1,464 @@
+/**
+ * Native stand-in for eosiolib/multi_index.hpp, backed by the in-memory database of
+ *   eosiolib/native/database.hpp.
+ */
+#pragma once
+
+#include <eosiolib/system.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/native/database.hpp>
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace eosio {
+
+    constexpr static inline name same_payer{};
+
+    template <name::raw IndexName, typename Extractor>
+    struct indexed_by {
+        enum constants { index_name = static_cast<uint64_t>(IndexName) };
+        typedef Extractor secondary_extractor_type;
+    };
+
+    template <class Class, class Type, Type (Class::*PtrToMemberFunction)()const>
+    struct const_mem_fun {
+        typedef typename std::remove_reference<Type>::type result_type;
+
+        template <typename ChainedPtr>
+        auto operator()( const ChainedPtr& x )const -> std::enable_if_t<!std::is_convertible<const ChainedPtr&, const Class&>::value, Type> {
+            return operator()(*x);
+        }
+
+        Type operator()( const Class& x )const {
+            return (x.*PtrToMemberFunction)();
+        }
+    };
+
+    template <name::raw TableName, typename T, typename... Indices>
+    class multi_index {
+        private:
+            typedef native::table_store<T, Indices...> store_type;
+            typedef typename store_type::container container;
+
+        public:
+            struct const_iterator {
+                public:
+                    typedef std::bidirectional_iterator_tag iterator_category;
+                    typedef const T                         value_type;
+                    typedef std::ptrdiff_t                  difference_type;
+                    typedef const T*                        pointer;
+                    typedef const T&                        reference;
+
+                    const T& operator*()const { return _it->second.value; }
+                    const T* operator->()const { return &_it->second.value; }
+
+                    const_iterator& operator++() {
+                        eosio_assert( !is_end(), "cannot increment end iterator" );
+                        ++native::db().counters.reads;
+                        ++_it;
+                        return *this;
+                    }
+
+                    const_iterator operator++( int ) {
+                        const_iterator result(*this);
+                        ++(*this);
+                        return result;
+                    }
+
+                    const_iterator& operator--() {
+                        _store = _mi->store();
+                        eosio_assert( _store != nullptr && _it != _store->rows.begin(), "cannot decrement iterator at beginning of table" );
+                        if( _is_end ) {
+                            _it = _store->rows.end();
+                            _is_end = false;
+                        }
+                        ++native::db().counters.reads;
+                        --_it;
+                        return *this;
+                    }
+
+                    const_iterator operator--( int ) {
+                        const_iterator result(*this);
+                        --(*this);
+                        return result;
+                    }
+
+                    friend bool operator == ( const const_iterator& a, const const_iterator& b ) {
+                        const bool a_end = a.is_end();
+                        const bool b_end = b.is_end();
+                        if( a_end || b_end )
+                            return a_end == b_end;
+                        return a._it == b._it;
+                    }
+
+                    friend bool operator != ( const const_iterator& a, const const_iterator& b ) {
+                        return !(a == b);
+                    }
+
+                    const_iterator() = default;
+
+                private:
+                    friend class multi_index;
+
+                    const_iterator( const multi_index* mi ) : _mi(mi), _store(nullptr), _is_end(true) {}
+
+                    const_iterator( const multi_index* mi, store_type* store, typename container::iterator it )
+                    : _mi(mi), _store(store), _it(it), _is_end(false) {}
+
+                    bool is_end()const { return _is_end || _store == nullptr || _it == _store->rows.end(); }
+
+                    const multi_index*            _mi = nullptr;
+                    store_type*                   _store = nullptr;
+                    typename container::iterator  _it;
+                    bool                          _is_end = true;
+            };
+
+            typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+            // Secondary index number I of the table. Iterators keep the (secondary key, primary key) pair
+            //   they are at, so they stay usable after the row they point to is modified or erased.
+            template <size_t I>
+            class index {
+                private:
+                    typedef typename std::tuple_element<I, std::tuple<Indices...>>::type index_type;
+                    typedef typename index_type::secondary_extractor_type extractor_type;
+
+                public:
+                    typedef typename extractor_type::result_type secondary_key_type;
+
+                    struct const_iterator {
+                        public:
+                            typedef std::bidirectional_iterator_tag iterator_category;
+                            typedef const T                         value_type;
+                            typedef std::ptrdiff_t                  difference_type;
+                            typedef const T*                        pointer;
+                            typedef const T&                        reference;
+
+                            const T& operator*()const {
+                                eosio_assert( !_is_end, "cannot dereference end iterator" );
+                                store_type* s = _mi->store();
+                                auto it = s->rows.find( _key.second );
+                                eosio_assert( it != s->rows.end(), "secondary index entry without a row" );
+                                return it->second.value;
+                            }
+
+                            const T* operator->()const { return &**this; }
+
+                            const_iterator& operator++() {
+                                eosio_assert( !_is_end, "cannot increment end iterator" );
+                                ++native::db().counters.reads;
+                                const auto& keys = std::get<I>( _mi->store()->indices );
+                                auto it = keys.upper_bound( _key );
+                                _is_end = it == keys.end();
+                                if( !_is_end )
+                                    _key = *it;
+                                return *this;
+                            }
+
+                            const_iterator operator++( int ) {
+                                const_iterator result(*this);
+                                ++(*this);
+                                return result;
+                            }
+
+                            const_iterator& operator--() {
+                                store_type* s = _mi->store();
+                                eosio_assert( s != nullptr, "cannot decrement iterator at beginning of index" );
+                                const auto& keys = std::get<I>( s->indices );
+                                auto it = _is_end ? keys.end() : keys.lower_bound( _key );
+                                eosio_assert( it != keys.begin(), "cannot decrement iterator at beginning of index" );
+                                ++native::db().counters.reads;
+                                _key = *--it;
+                                _is_end = false;
+                                return *this;
+                            }
+
+                            const_iterator operator--( int ) {
+                                const_iterator result(*this);
+                                --(*this);
+                                return result;
+                            }
+
+                            friend bool operator == ( const const_iterator& a, const const_iterator& b ) {
+                                if( a._is_end || b._is_end )
+                                    return a._is_end == b._is_end;
+                                return a._key == b._key;
+                            }
+
+                            friend bool operator != ( const const_iterator& a, const const_iterator& b ) {
+                                return !(a == b);
+                            }
+
+                            const_iterator() = default;
+
+                        private:
+                            friend class index;
+
+                            const_iterator( const multi_index* mi ) : _mi(mi) {}
+
+                            const_iterator( const multi_index* mi, std::pair<secondary_key_type, uint64_t> key )
+                            : _mi(mi), _key(std::move(key)), _is_end(false) {}
+
+                            const multi_index*                        _mi = nullptr;
+                            std::pair<secondary_key_type, uint64_t>   _key;
+                            bool                                      _is_end = true;
+                    };
+
+                    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+                    explicit index( multi_index* mi ) : _mi(mi) {}
+
+                    const_iterator cbegin()const { return begin(); }
+
+                    const_iterator begin()const {
+                        ++native::db().counters.reads;
+                        store_type* s = _mi->store();
+                        if( s == nullptr || std::get<I>( s->indices ).empty() )
+                            return end();
+                        return const_iterator( _mi, *std::get<I>( s->indices ).begin() );
+                    }
+
+                    const_iterator cend()const { return end(); }
+
+                    const_iterator end()const { return const_iterator( _mi ); }
+
+                    const_reverse_iterator rbegin()const { return std::make_reverse_iterator( end() ); }
+                    const_reverse_iterator rend()const   { return std::make_reverse_iterator( begin() ); }
+
+                    // First entry whose secondary key is not less than "secondary".
+                    const_iterator lower_bound( const secondary_key_type& secondary )const {
+                        return at( [&]( const auto& keys ) { return keys.lower_bound( std::make_pair( secondary, uint64_t(0) ) ); } );
+                    }
+
+                    // First entry whose secondary key is greater than "secondary".
+                    const_iterator upper_bound( const secondary_key_type& secondary )const {
+                        return at( [&]( const auto& keys ) {
+                            return keys.upper_bound( std::make_pair( secondary, std::numeric_limits<uint64_t>::max() ) );
+                        });
+                    }
+
+                    // First entry with the secondary key "secondary", or end().
+                    const_iterator find( const secondary_key_type& secondary )const {
+                        auto it = lower_bound( secondary );
+                        if( it != end() && it._key.first != secondary )
+                            return end();
+                        return it;
+                    }
+
+                    const T& get( const secondary_key_type& secondary, const char* error_msg = "unable to find secondary key" )const {
+                        auto it = find( secondary );
+                        eosio_assert( it != end(), error_msg );
+                        return *it;
+                    }
+
+                    const_iterator iterator_to( const T& obj )const {
+                        _mi->iterator_to( obj );
+                        return const_iterator( _mi, std::make_pair( extractor_type()( obj ), obj.primary_key() ) );
+                    }
+
+                    template <typename Lambda>
+                    void modify( const_iterator itr, name payer, Lambda&& updater ) {
+                        eosio_assert( itr != end(), "cannot pass end iterator to modify" );
+                        _mi->modify( *itr, payer, std::forward<Lambda&&>(updater) );
+                    }
+
+                    // Erases the row "itr" points to, and returns the entry after it.
+                    const_iterator erase( const_iterator itr ) {
+                        eosio_assert( itr != end(), "cannot pass end iterator to erase" );
+                        const T& obj = *itr;
+                        ++itr;
+                        _mi->erase( obj );
+                        return itr;
+                    }
+
+                private:
+                    template <typename Bound>
+                    const_iterator at( Bound&& bound )const {
+                        ++native::db().counters.reads;
+                        store_type* s = _mi->store();
+                        if( s == nullptr )
+                            return end();
+                        const auto& keys = std::get<I>( s->indices );
+                        auto it = bound( keys );
+                        if( it == keys.end() )
+                            return end();
+                        return const_iterator( _mi, *it );
+                    }
+
+                    multi_index* _mi;
+            };
+
+            multi_index( name code, uint64_t scope ) : _code(code), _scope(scope) {}
+
+            multi_index( const multi_index& ) = delete;
+            multi_index& operator=( const multi_index& ) = delete;
+
+            name get_code()const { return _code; }
+
+            uint64_t get_scope()const { return _scope; }
+
+            const_iterator cbegin()const { return begin(); }
+
+            const_iterator begin()const {
+                ++native::db().counters.reads;
+                store_type* s = store();
+                if( s == nullptr )
+                    return end();
+                return const_iterator( this, s, s->rows.begin() );
+            }
+
+            const_iterator cend()const { return end(); }
+
+            const_iterator end()const { return const_iterator( this ); }
+
+            const_reverse_iterator crbegin()const { return std::make_reverse_iterator( cend() ); }
+            const_reverse_iterator rbegin()const  { return std::make_reverse_iterator( end() ); }
+            const_reverse_iterator crend()const   { return std::make_reverse_iterator( cbegin() ); }
+            const_reverse_iterator rend()const    { return std::make_reverse_iterator( begin() ); }
+
+            const_iterator lower_bound( uint64_t primary )const {
+                ++native::db().counters.reads;
+                store_type* s = store();
+                if( s == nullptr )
+                    return end();
+                return const_iterator( this, s, s->rows.lower_bound( primary ) );
+            }
+
+            const_iterator upper_bound( uint64_t primary )const {
+                ++native::db().counters.reads;
+                store_type* s = store();
+                if( s == nullptr )
+                    return end();
+                return const_iterator( this, s, s->rows.upper_bound( primary ) );
+            }
+
+            uint64_t available_primary_key()const {
+                store_type* s = store();
+                if( s == nullptr || s->rows.empty() )
+                    return 0;
+                const uint64_t last = s->rows.rbegin()->first;
+                eosio_assert( last < std::numeric_limits<uint64_t>::max() - 1, "next primary key in table is at autoincrement limit" );
+                return last + 1;
+            }
+
+            const_iterator find( uint64_t primary )const {
+                ++native::db().counters.reads;
+                store_type* s = store();
+                if( s == nullptr )
+                    return end();
+                auto it = s->rows.find( primary );
+                if( it == s->rows.end() )
+                    return end();
+                return const_iterator( this, s, it );
+            }
+
+            const_iterator require_find( uint64_t primary, const char* error_msg = "unable to find key" )const {
+                auto itr = find( primary );
+                eosio_assert( itr != end(), error_msg );
+                return itr;
+            }
+
+            const T& get( uint64_t primary, const char* error_msg = "unable to find key" )const {
+                auto result = find( primary );
+                eosio_assert( result != end(), error_msg );
+                return *result;
+            }
+
+            const_iterator iterator_to( const T& obj )const {
+                store_type* s = store();
+                eosio_assert( s != nullptr, "object passed to iterator_to is not in multi_index" );
+                auto it = s->rows.find( obj.primary_key() );
+                eosio_assert( it != s->rows.end() && &it->second.value == &obj, "object passed to iterator_to is not in multi_index" );
+                return const_iterator( this, s, it );
+            }
+
+            template <typename Lambda>
+            const_iterator emplace( name payer, Lambda&& constructor ) {
+                eosio_assert( _code == native::current_receiver(), "cannot create objects in table of another contract" );
+                ++native::db().counters.writes;
+
+                T obj;
+                constructor( obj );
+
+                store_type& s = native::db().template get_table<store_type>( _code, _scope, name(TableName) );
+                _store = &s;
+                return const_iterator( this, _store, s.insert( native::db(), std::move(obj), payer ) );
+            }
+
+            template <typename Lambda>
+            void modify( const_iterator itr, name payer, Lambda&& updater ) {
+                eosio_assert( itr != end(), "cannot pass end iterator to modify" );
+                modify( *itr, payer, std::forward<Lambda&&>(updater) );
+            }
+
+            template <typename Lambda>
+            void modify( const T& obj, name payer, Lambda&& updater ) {
+                eosio_assert( _code == native::current_receiver(), "cannot modify objects in table of another contract" );
+                ++native::db().counters.writes;
+
+                store_type* s = store();
+                const uint64_t pk = obj.primary_key();
+                eosio_assert( s != nullptr, "object passed to modify is not in multi_index" );
+                auto it = s->rows.find( pk );
+                eosio_assert( it != s->rows.end() && &it->second.value == &obj, "object passed to modify is not in multi_index" );
+
+                typename store_type::row old = it->second;
+                updater( it->second.value );
+                eosio_assert( pk == it->second.value.primary_key(), "updater cannot change primary key when modifying an object" );
+                if( payer != same_payer )
+                    it->second.payer = payer;
+                s->updated( native::db(), it, std::move(old) );
+            }
+
+            const_iterator erase( const_iterator itr ) {
+                eosio_assert( itr != end(), "cannot pass end iterator to erase" );
+                eosio_assert( _code == native::current_receiver(), "cannot erase objects in table of another contract" );
+                ++native::db().counters.writes;
+
+                auto next = itr._store->remove( native::db(), itr._it );
+                return const_iterator( this, itr._store, next );
+            }
+
+            void erase( const T& obj ) {
+                erase( iterator_to( obj ) );
+            }
+
+            template <name::raw IndexName>
+            auto get_index() {
+                return index<index_position<IndexName>()>( this );
+            }
+
+            template <name::raw IndexName>
+            auto get_index()const {
+                return index<index_position<IndexName>()>( const_cast<multi_index*>( this ) );
+            }
+
+        private:
+            // Position of the index named IndexName among Indices.
+            template <name::raw IndexName>
+            static constexpr size_t index_position() {
+                constexpr uint64_t names[] = { static_cast<uint64_t>(Indices::index_name)..., 0 };
+                size_t i = 0;
+                while( i < sizeof...(Indices) && names[i] != static_cast<uint64_t>(IndexName) )
+                    ++i;
+                static_assert( sizeof...(Indices) > 0, "table has no secondary index" );
+                return i;
+            }
+
+            store_type* store()const {
+                if( _store == nullptr )
+                    _store = native::db().template find_table<store_type>( _code, _scope, name(TableName) );
+                return _store;
+            }
+
+            name                 _code;
+            uint64_t             _scope;
+            mutable store_type*  _store = nullptr;
+    };
+
+} /// namespace eosio
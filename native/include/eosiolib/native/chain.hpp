@@ -0,0 +1,164 @@
+/**
+ * In-memory chain that runs contract code natively.
+ *
+ * Serves the eosiolib intrinsics (auth, time, notifications, inline actions, database) to
+ *   contract classes registered through EOSIO_DISPATCH, and records what every pushed action
+ *   costs: DB reads and writes, notifications, inline actions and action data bytes.
+ *
+ * Transactions are atomic: if any action of a transaction fails an eosio_assert, every
+ *   database change made by the transaction is reverted.
+ */
+#pragma once
+
+#include <eosiolib/action.hpp>
+#include <eosiolib/dispatcher.hpp>
+#include <eosiolib/native/database.hpp>
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace eosio { namespace native {
+
+    constexpr uint64_t microseconds_per_day = 86400000000ull;
+
+    // nodeos rejects inline actions nested deeper than this.
+    constexpr uint32_t max_inline_action_depth = 4;
+
+    // Accumulated cost of the actions pushed with one action name (inline actions included).
+    struct action_stats {
+        uint64_t count          = 0;
+        uint64_t failed         = 0;
+        uint64_t db_reads       = 0;
+        uint64_t db_writes      = 0;
+        uint64_t notifications  = 0;
+        uint64_t inline_actions = 0;
+        uint64_t data_bytes     = 0;
+    };
+
+    struct push_result {
+        bool        ok = true;
+        std::string error;
+
+        explicit operator bool()const { return ok; }
+    };
+
+    // What a transaction did besides running its own actions: the inline actions it sent and the accounts
+    //   it notified, in execution order.
+    struct transaction_trace {
+        std::vector<action>  inlines;
+        std::vector<name>    notified;
+    };
+
+    class chain {
+        public:
+            static chain& instance();
+
+            database db;
+
+            // Every account is considered to exist, unless this is turned off.
+            bool implicit_accounts = true;
+
+            // print() output is collected in "console" only when this is on.
+            bool console_enabled = false;
+            std::string console;
+
+            // The inline actions and notifications of the last transaction are kept in "trace" only
+            //   when this is on.
+            bool tracing = false;
+            transaction_trace trace;
+
+            std::map<uint64_t, action_stats> stats;
+
+            // Clears every table, account, statistic and the clock.
+            void reset();
+
+            void reset_stats() { stats.clear(); }
+
+            uint64_t time()const { return _now; }
+
+            void set_time( uint64_t microseconds ) { _now = microseconds; }
+
+            // Noon of the given day since the epoch.
+            void set_day( uint32_t day ) { _now = day * microseconds_per_day + microseconds_per_day / 2; }
+
+            uint32_t day()const { return static_cast<uint32_t>( _now / microseconds_per_day ); }
+
+            void advance_days( uint32_t days ) { _now += days * microseconds_per_day; }
+
+            void create_account( name account ) { _accounts.insert( account.value ); }
+
+            bool account_exists( name account )const {
+                return implicit_accounts || _accounts.count( account.value ) > 0;
+            }
+
+            template <typename Contract>
+            void set_code( name account ) {
+                create_account( account );
+                _codes[ account.value ] = &abi_of<Contract>();
+            }
+
+            push_result push_transaction( const std::vector<action>& actions );
+
+            template <typename... Args>
+            push_result push_action( name account, name act, std::vector<permission_level> auths, const Args&... args ) {
+                return push_transaction( { action( std::move(auths), account, act, std::make_tuple( args... ) ) } );
+            }
+
+            // Runs f with the database counters left untouched, to inspect state between actions.
+            template <typename F>
+            auto peek( F&& f ) {
+                const db_counters saved = db.counters;
+                struct restore {
+                    database& d; db_counters c;
+                    ~restore() { d.counters = c; }
+                } guard{ db, saved };
+                return f();
+            }
+
+            // Runs f as the code of "receiver", authorized by "auths", with the database counters left untouched:
+            //   to seed tables with rows that no action writes anymore, such as those of legacy tables.
+            template <typename F>
+            auto run_as( name receiver, std::vector<permission_level> auths, F&& f ) {
+                action act;
+                act.account = receiver;
+                act.authorization = std::move( auths );
+                apply_context ctx{ &act, receiver, {}, {} };
+                struct restore {
+                    chain& c; apply_context* parent;
+                    ~restore() { c._context = parent; }
+                } guard{ *this, _context };
+                _context = &ctx;
+                return peek( std::forward<F>(f) );
+            }
+
+            // Intrinsics, called from the contract through eosiolib.
+            void require_auth( name account )const;
+            bool has_auth( name account )const;
+            void require_recipient( name account );
+            void send_inline( const action& act );
+            name current_receiver()const;
+            void check_ram_payer( name payer )const;
+
+        private:
+            struct apply_context {
+                const action*        act;
+                name                 receiver;
+                std::vector<name>    notified;
+                std::vector<action>  inlines;
+            };
+
+            void execute( const action& act, uint32_t depth, action_stats& st );
+
+            uint64_t                         _now = 0;
+            std::unordered_set<uint64_t>     _accounts;
+            std::map<uint64_t, contract_abi*> _codes;
+            apply_context*                   _context = nullptr;
+    };
+
+}} /// namespace eosio::native
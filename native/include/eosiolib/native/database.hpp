@@ -0,0 +1,257 @@
+/**
+ * In-memory contract database behind the native multi_index.
+ *
+ * Rows are kept as C++ objects (no serialization round trip), one ordered map per
+ *   (code, scope, table). Every write is billed the way nodeos bills RAM (packed row size plus
+ *   a fixed per-row and per-table overhead) and journaled, so a failed transaction can be
+ *   reverted. Reads and writes are counted to report DB calls per action.
+ */
+#pragma once
+
+#include <eosiolib/system.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/datastream.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace eosio { namespace native {
+
+    // Approximations of the nodeos billable sizes of key_value_object, table_id_object and index64_object.
+    constexpr int64_t billable_row_overhead   = 112;
+    constexpr int64_t billable_table_overhead = 112;
+    constexpr int64_t billable_index_overhead = 128;
+
+    struct db_counters {
+        uint64_t reads  = 0;
+        uint64_t writes = 0;
+    };
+
+    struct table_key {
+        uint64_t code;
+        uint64_t scope;
+        uint64_t table;
+
+        friend bool operator < ( const table_key& a, const table_key& b ) {
+            return std::tie( a.code, a.scope, a.table ) < std::tie( b.code, b.scope, b.table );
+        }
+    };
+
+    class database;
+
+    class table_base {
+        public:
+            virtual ~table_base() = default;
+
+            virtual size_t row_count()const = 0;
+
+            // Packed size of all the rows, without overheads.
+            virtual int64_t row_bytes()const = 0;
+
+            name payer;
+    };
+
+    class database {
+        public:
+            db_counters counters;
+
+            // Total billable RAM, and billable RAM per payer.
+            int64_t ram_bytes = 0;
+            std::unordered_map<uint64_t, int64_t> ram_usage;
+
+            std::map<table_key, std::unique_ptr<table_base>> tables;
+
+            // Undo log of the running transaction.
+            bool journaling = false;
+            std::vector<std::function<void()>> journal;
+
+            void bill( name payer, int64_t delta ) {
+                ram_bytes += delta;
+                ram_usage[payer.value] += delta;
+            }
+
+            void record_undo( std::function<void()> undo ) {
+                if( journaling )
+                    journal.emplace_back( std::move(undo) );
+            }
+
+            void begin() {
+                journal.clear();
+                journaling = true;
+            }
+
+            void commit() {
+                journal.clear();
+                journaling = false;
+            }
+
+            void rollback() {
+                journaling = false;
+                for( auto it = journal.rbegin(); it != journal.rend(); ++it )
+                    (*it)();
+                journal.clear();
+            }
+
+            template <typename Store>
+            Store* find_table( name code, uint64_t scope, name table ) {
+                auto it = tables.find( table_key{code.value, scope, table.value} );
+                if( it == tables.end() )
+                    return nullptr;
+                auto* store = dynamic_cast<Store*>( it->second.get() );
+                eosio_assert( store != nullptr, "table was opened with a different row type" );
+                return store;
+            }
+
+            template <typename Store>
+            Store& get_table( name code, uint64_t scope, name table ) {
+                auto& slot = tables[ table_key{code.value, scope, table.value} ];
+                if( !slot )
+                    slot.reset( new Store() );
+                auto* store = dynamic_cast<Store*>( slot.get() );
+                eosio_assert( store != nullptr, "table was opened with a different row type" );
+                return *store;
+            }
+
+            size_t row_count()const {
+                size_t n = 0;
+                for( const auto& t : tables )
+                    n += t.second->row_count();
+                return n;
+            }
+
+            size_t table_count()const {
+                size_t n = 0;
+                for( const auto& t : tables )
+                    n += t.second->row_count() > 0;
+                return n;
+            }
+
+            int64_t row_bytes()const {
+                int64_t n = 0;
+                for( const auto& t : tables )
+                    n += t.second->row_bytes();
+                return n;
+            }
+    };
+
+    // The database of the native chain.
+    database& db();
+
+    // Account whose code is running, which is the only one allowed to write its tables.
+    name current_receiver();
+
+    // Fails unless the running action can bill RAM to "payer", as nodeos checks for every row that
+    //   grows or is created: "payer" must be the receiver or have authorized the action.
+    void check_ram_payer( name payer );
+
+    // The rows of one table, and one ordered set of (secondary key, primary key) pairs for each of its
+    //   secondary indices (the indexed_by arguments of its multi_index).
+    template <typename T, typename... Indices>
+    class table_store : public table_base {
+        public:
+            struct row {
+                T       value;
+                name    payer;
+                int64_t packed = 0;
+
+                int64_t billable()const { return packed + billable_row_overhead + int64_t(sizeof...(Indices)) * billable_index_overhead; }
+            };
+
+            typedef std::map<uint64_t, row> container;
+
+            template <typename Index>
+            using secondary_keys = std::set<std::pair<typename Index::secondary_extractor_type::result_type, uint64_t>>;
+
+            container                                 rows;
+            std::tuple<secondary_keys<Indices>...>    indices;
+            int64_t                                   bytes = 0;
+
+            size_t row_count()const override { return rows.size(); }
+
+            int64_t row_bytes()const override { return bytes; }
+
+            typename container::iterator insert( database& d, T&& value, name payer ) {
+                const uint64_t pk = value.primary_key();
+                auto res = rows.emplace( pk, row{ std::move(value), payer } );
+                eosio_assert( res.second, "could not insert object, most likely a uniqueness constraint was violated" );
+
+                check_ram_payer( payer );
+                auto it = res.first;
+                if( rows.size() == 1 ) {
+                    this->payer = payer;
+                    d.bill( payer, billable_table_overhead );
+                }
+                row& r = it->second;
+                r.packed = static_cast<int64_t>( pack_size( r.value ) );
+                bytes += r.packed;
+                index( r.value, pk, true, std::index_sequence_for<Indices...>() );
+                d.bill( r.payer, r.billable() );
+                d.record_undo( [this, &d, pk]() { remove( d, rows.find( pk ) ); } );
+                return it;
+            }
+
+            // Re-bills a row after its value or payer was changed in place. "old" is its previous state.
+            void updated( database& d, typename container::iterator it, row&& old ) {
+                row& r = it->second;
+                r.packed = static_cast<int64_t>( pack_size( r.value ) );
+                if( r.payer != old.payer || r.packed > old.packed )
+                    check_ram_payer( r.payer );
+                bytes += r.packed - old.packed;
+                index( old.value, it->first, false, std::index_sequence_for<Indices...>() );
+                index( r.value, it->first, true, std::index_sequence_for<Indices...>() );
+                d.bill( old.payer, -old.billable() );
+                d.bill( r.payer, r.billable() );
+                d.record_undo( [this, &d, pk = it->first, old = std::move(old)]() mutable {
+                    row& cur = rows.find( pk )->second;
+                    bytes += old.packed - cur.packed;
+                    index( cur.value, pk, false, std::index_sequence_for<Indices...>() );
+                    index( old.value, pk, true, std::index_sequence_for<Indices...>() );
+                    d.bill( cur.payer, -cur.billable() );
+                    d.bill( old.payer, old.billable() );
+                    cur = std::move( old );
+                });
+            }
+
+            typename container::iterator remove( database& d, typename container::iterator it ) {
+                row& r = it->second;
+                bytes -= r.packed;
+                index( r.value, it->first, false, std::index_sequence_for<Indices...>() );
+                d.bill( r.payer, -r.billable() );
+                if( d.journaling ) {
+                    d.record_undo( [this, &d, old = std::move(r)]() mutable {
+                        insert( d, std::move(old.value), old.payer );
+                    });
+                }
+                auto next = rows.erase( it );
+                if( rows.empty() )
+                    d.bill( this->payer, -billable_table_overhead );
+                return next;
+            }
+
+        private:
+            // Adds the secondary keys of "value" to every index, or removes them.
+            template <size_t... I>
+            void index( const T& value, uint64_t pk, bool add, std::index_sequence<I...> ) {
+                ( index_one<I>( value, pk, add ), ... );
+            }
+
+            template <size_t I>
+            void index_one( const T& value, uint64_t pk, bool add ) {
+                typedef typename std::tuple_element<I, std::tuple<Indices...>>::type index_type;
+                const auto entry = std::make_pair( typename index_type::secondary_extractor_type()( value ), pk );
+                if( add )
+                    std::get<I>( indices ).insert( entry );
+                else
+                    std::get<I>( indices ).erase( entry );
+            }
+    };
+
+}} /// namespace eosio::native
@@ -0,0 +1,85 @@
+/**
+ * Field reflection for plain aggregate structs.
+ *
+ * The chain build gets the serializers of [[eosio::table]] and action structs generated by
+ *   eosio-cpp. The native build has no code generator, so it visits the fields of any aggregate
+ *   through structured bindings instead. Field counts are found by brace-initialization probing.
+ */
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace eosio { namespace native {
+
+    namespace detail {
+        struct any_field {
+            template <typename T>
+            constexpr operator T()const;
+        };
+
+        template <typename T, typename Seq, typename = void>
+        struct is_brace_constructible : std::false_type {};
+
+        template <typename T, std::size_t... I>
+        struct is_brace_constructible< T, std::index_sequence<I...>,
+                                       std::void_t<decltype( T{ (void(I), any_field{})... } )> > : std::true_type {};
+
+        template <typename T, std::size_t N>
+        constexpr std::size_t count_fields() {
+            if constexpr ( N == 0 ) {
+                return 0;
+            } else if constexpr ( is_brace_constructible<T, std::make_index_sequence<N>>::value ) {
+                return N;
+            } else {
+                return count_fields<T, N - 1>();
+            }
+        }
+    } /// namespace detail
+
+    template <typename T>
+    constexpr bool is_reflectable_v = std::is_aggregate_v<T> && !std::is_array_v<T>;
+
+    template <typename T>
+    constexpr std::size_t field_count_v = detail::count_fields<T, 12>();
+
+    // Calls f on every field of the aggregate t, in declaration order.
+    template <typename T, typename F>
+    void for_each_field( T& t, F&& f ) {
+        constexpr std::size_t n = field_count_v< std::remove_const_t<T> >;
+        static_assert( n <= 12, "reflection supports up to 12 fields" );
+
+        if constexpr ( n == 0 ) {
+        } else if constexpr ( n == 1 ) {
+            auto& [a] = t; f(a);
+        } else if constexpr ( n == 2 ) {
+            auto& [a, b] = t; f(a); f(b);
+        } else if constexpr ( n == 3 ) {
+            auto& [a, b, c] = t; f(a); f(b); f(c);
+        } else if constexpr ( n == 4 ) {
+            auto& [a, b, c, d] = t; f(a); f(b); f(c); f(d);
+        } else if constexpr ( n == 5 ) {
+            auto& [a, b, c, d, e] = t; f(a); f(b); f(c); f(d); f(e);
+        } else if constexpr ( n == 6 ) {
+            auto& [a, b, c, d, e, g] = t; f(a); f(b); f(c); f(d); f(e); f(g);
+        } else if constexpr ( n == 7 ) {
+            auto& [a, b, c, d, e, g, h] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h);
+        } else if constexpr ( n == 8 ) {
+            auto& [a, b, c, d, e, g, h, i] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i);
+        } else if constexpr ( n == 9 ) {
+            auto& [a, b, c, d, e, g, h, i, j] = t;
+            f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j);
+        } else if constexpr ( n == 10 ) {
+            auto& [a, b, c, d, e, g, h, i, j, k] = t;
+            f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k);
+        } else if constexpr ( n == 11 ) {
+            auto& [a, b, c, d, e, g, h, i, j, k, l] = t;
+            f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l);
+        } else {
+            auto& [a, b, c, d, e, g, h, i, j, k, l, m] = t;
+            f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l); f(m);
+        }
+    }
+
+}} /// namespace eosio::native
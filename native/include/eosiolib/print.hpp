@@ -0,0 +1,55 @@
+/**
+ * Native stand-in for eosiolib/print.hpp. Output goes to the console of the native chain.
+ */
+#pragma once
+
+#include <eosiolib/name.hpp>
+#include <eosiolib/symbol.hpp>
+#include <eosiolib/asset.hpp>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace eosio {
+
+    namespace native {
+        void console_append( const char* s, size_t len );
+    }
+
+    inline void printl( const char* ptr, size_t len ) { native::console_append( ptr, len ); }
+
+    inline void print( const char* ptr ) { printl( ptr, std::char_traits<char>::length(ptr) ); }
+
+    inline void print( const std::string& s ) { printl( s.data(), s.size() ); }
+
+    inline void print( char c ) { printl( &c, 1 ); }
+
+    inline void print( bool b ) { print( b ? "true" : "false" ); }
+
+    template <typename T, std::enable_if_t< std::is_integral_v<T> >* = nullptr>
+    inline void print( T num ) { print( std::to_string( num ) ); }
+
+    inline void print( double d ) { print( std::to_string( d ) ); }
+
+    inline void print( name n ) { print( n.to_string() ); }
+
+    inline void print( symbol_code sc ) { print( sc.to_string() ); }
+
+    inline void print( symbol s ) {
+        print( std::to_string( s.precision() ) );
+        print( ',' );
+        print( s.code() );
+    }
+
+    inline void print( const asset& a ) { print( a.to_string() ); }
+
+    template <typename Arg, typename Arg2, typename... Args>
+    inline void print( Arg&& a, Arg2&& a2, Args&&... args ) {
+        print( std::forward<Arg>(a) );
+        print( std::forward<Arg2>(a2), std::forward<Args>(args)... );
+    }
+
+    inline void print_f( const char* s ) { print( s ); }
+
+} /// namespace eosio
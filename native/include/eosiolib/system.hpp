@@ -0,0 +1,47 @@
+/**
+ * Native stand-in for the eosiolib system intrinsics.
+ *
+ * On a real chain these functions are imported from nodeos. Here they are served by the
+ *   in-memory chain in eosiolib/native/chain.hpp, so the contract sources compile unchanged
+ *   for the host.
+ */
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace eosio { namespace native {
+
+    // Thrown by eosio_assert(); the native chain catches it and reverts the transaction.
+    struct eosio_assert_exception : public std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+}} /// namespace eosio::native
+
+extern "C" {
+
+    void eosio_assert( uint32_t test, const char* msg );
+
+    void eosio_assert_message( uint32_t test, const char* msg, uint32_t msg_len );
+
+    // Microseconds since the epoch, as set on the native chain.
+    uint64_t current_time();
+
+    // Seconds since the epoch.
+    uint32_t now();
+
+}
+
+namespace eosio {
+
+    inline void check( bool pred, const char* msg ) {
+        eosio_assert( pred, msg );
+    }
+
+    inline void check( bool pred, const std::string& msg ) {
+        eosio_assert( pred, msg.c_str() );
+    }
+
+} /// namespace eosio
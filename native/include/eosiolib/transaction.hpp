@@ -0,0 +1,7 @@
+/**
+ * Native stand-in for eosiolib/transaction.hpp. Only inline actions are supported by the
+ *   native chain; deferred transactions are not.
+ */
+#pragma once
+
+#include <eosiolib/action.hpp>
@@ -0,0 +1,202 @@
+/**
+ * Native chain and the eosiolib intrinsics it serves.
+ */
+
+#include <eosiolib/native/chain.hpp>
+#include <eosiolib/print.hpp>
+
+#include <algorithm>
+
+namespace eosio { namespace native {
+
+chain& chain::instance() {
+    static chain c;
+    return c;
+}
+
+database& db() {
+    return chain::instance().db;
+}
+
+name current_receiver() {
+    return chain::instance().current_receiver();
+}
+
+void check_ram_payer( name payer ) {
+    chain::instance().check_ram_payer( payer );
+}
+
+void console_append( const char* s, size_t len ) {
+    chain& c = chain::instance();
+    if (c.console_enabled)
+        c.console.append( s, len );
+}
+
+void send_inline( const action& act ) {
+    chain::instance().send_inline( act );
+}
+
+void chain::reset() {
+    db = database();
+    console.clear();
+    trace = transaction_trace();
+    stats.clear();
+    _now = 0;
+    _accounts.clear();
+    _codes.clear();
+    _context = nullptr;
+}
+
+push_result chain::push_transaction( const std::vector<action>& actions ) {
+    eosio_assert( _context == nullptr, "cannot push a transaction from inside an action" );
+
+    push_result result;
+    if (tracing)
+        trace = transaction_trace();
+    db.begin();
+    std::vector<std::pair<uint64_t, action_stats>> traces;
+    traces.reserve( actions.size() );
+    try {
+        for (const auto& act : actions) {
+            traces.emplace_back( act.name.value, action_stats{} );
+            action_stats& st = traces.back().second;
+            const db_counters before = db.counters;
+            execute( act, 0, st );
+            st.db_reads  = db.counters.reads - before.reads;
+            st.db_writes = db.counters.writes - before.writes;
+        }
+        db.commit();
+    } catch (const eosio_assert_exception& e) {
+        _context = nullptr;
+        db.rollback();
+        result.ok = false;
+        result.error = e.what();
+    }
+
+    for (const auto& t : traces) {
+        action_stats& st = stats[t.first];
+        ++st.count;
+        st.failed         += !result.ok;
+        st.db_reads       += t.second.db_reads;
+        st.db_writes      += t.second.db_writes;
+        st.notifications  += t.second.notifications;
+        st.inline_actions += t.second.inline_actions;
+        st.data_bytes     += t.second.data_bytes;
+    }
+    return result;
+}
+
+void chain::execute( const action& act, uint32_t depth, action_stats& st ) {
+    eosio_assert( depth <= max_inline_action_depth, "max inline action depth per transaction reached" );
+    eosio_assert( account_exists( act.account ), "action's code account does not exist" );
+
+    apply_context ctx{ &act, act.account, {}, {} };
+    apply_context* parent = _context;
+    _context = &ctx;
+
+    st.data_bytes += act.data.size();
+    auto code = _codes.find( act.account.value );
+    if (code != _codes.end()) {
+        auto handler = code->second->handlers.find( act.name.value );
+        if (handler != code->second->handlers.end())
+            handler->second( act.account, act.account, act.data );
+    }
+
+    // Notified accounts run their own code with the action's code as "code"; contracts built
+    //   with EOSIO_DISPATCH ignore those, so they are only counted here.
+    st.notifications += ctx.notified.size();
+    if (tracing)
+        trace.notified.insert( trace.notified.end(), ctx.notified.begin(), ctx.notified.end() );
+
+    _context = parent;
+
+    for (const auto& inl : ctx.inlines) {
+        ++st.inline_actions;
+        if (tracing)
+            trace.inlines.push_back( inl );
+        execute( inl, depth + 1, st );
+    }
+}
+
+void chain::require_auth( name account )const {
+    if (!has_auth( account )) {
+        std::string msg = "missing authority of " + account.to_string();
+        eosio_assert( false, msg.c_str() );
+    }
+}
+
+bool chain::has_auth( name account )const {
+    eosio_assert( _context != nullptr, "authorization can only be checked inside an action" );
+    for (const auto& auth : _context->act->authorization) {
+        if (auth.actor == account)
+            return true;
+    }
+    return false;
+}
+
+void chain::require_recipient( name account ) {
+    eosio_assert( _context != nullptr, "require_recipient can only be called inside an action" );
+    if (account == _context->receiver)
+        return;
+    auto& notified = _context->notified;
+    if (std::find( notified.begin(), notified.end(), account ) == notified.end())
+        notified.push_back( account );
+}
+
+void chain::send_inline( const action& act ) {
+    eosio_assert( _context != nullptr, "inline actions can only be sent inside an action" );
+    _context->inlines.push_back( act );
+}
+
+name chain::current_receiver()const {
+    return _context != nullptr ? _context->receiver : name();
+}
+
+void chain::check_ram_payer( name payer )const {
+    // Rows restored by the undo of a failed transaction are not billed by an action.
+    if (_context == nullptr || payer == _context->receiver)
+        return;
+    require_auth( payer );
+}
+
+}} /// namespace eosio::native
+
+using eosio::native::chain;
+
+extern "C" {
+
+void eosio_assert( uint32_t test, const char* msg ) {
+    if (!test)
+        throw eosio::native::eosio_assert_exception( std::string("assertion failure with message: ") + msg );
+}
+
+void eosio_assert_message( uint32_t test, const char* msg, uint32_t msg_len ) {
+    if (!test)
+        throw eosio::native::eosio_assert_exception( "assertion failure with message: " + std::string( msg, msg_len ) );
+}
+
+uint64_t current_time() {
+    return chain::instance().time();
+}
+
+uint32_t now() {
+    return static_cast<uint32_t>( chain::instance().time() / 1000000 );
+}
+
+void require_auth( uint64_t name ) {
+    chain::instance().require_auth( eosio::name(name) );
+}
+
+bool has_auth( uint64_t name ) {
+    return chain::instance().has_auth( eosio::name(name) );
+}
+
+void require_recipient( uint64_t name ) {
+    chain::instance().require_recipient( eosio::name(name) );
+}
+
+bool is_account( uint64_t name ) {
+    return chain::instance().account_exists( eosio::name(name) );
+}
+
+}
@@ -0,0 +1,395 @@
+/**
+ * Size and cost budgets of the revelation21 contract.
+ *
+ * Reports the size of every section of the contract WASM, and what every action of a fixed scenario
+ *   costs on the native chain: host instructions per call (when the kernel lets perf_event_open count
+ *   them), DB reads and writes, and inline actions. Exits with 1 if anything is over its budget.
+ *
+ *   revelation21_budget [--wasm FILE] [--source FILE]... [--config NAME] [--budgets FILE] [--allow-stale-wasm]
+ *                       [--allow-uncounted] [--record-sources | --set-wasm-budgets]
+ *
+ * The WASM must be built from the --source files as they are, or its sizes say nothing about the code
+ *   under review. "--record-sources", run right after eosio-cpp builds it, writes a hash of the sources
+ *   and of the UBI --config to FILE.sources, next to the WASM; the check then fails, unless
+ *   --allow-stale-wasm is given, when that record is missing or does not match the sources. Likewise,
+ *   instruction budgets that cannot be checked because perf_event_open is unavailable fail it unless
+ *   --allow-uncounted is given. "--set-wasm-budgets" rewrites the wasm.* budgets of the budgets file to
+ *   the sizes of a WASM that matches its sources, plus 2%, for when the contract grows on purpose.
+ *
+ * The budgets file has one "<key> <maximum>" per line, "#" starting a comment. Keys are "wasm.total",
+ *   "wasm.<section>" (code, data, import, ...) in bytes, and "<action>.<cost>" per call, with cost one
+ *   of instructions, reads, writes or inlines. Costs without a budget are only reported.
+ */
+
+#include "token_driver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace eosio;
+using revelation21::token_driver;
+
+namespace {
+
+// User-space instructions retired by this thread.
+class instruction_counter {
+    public:
+        instruction_counter() {
+#ifdef __linux__
+            perf_event_attr attr;
+            std::memset( &attr, 0, sizeof(attr) );
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            _fd = static_cast<int>( syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 ) );
+            if (_fd >= 0) {
+                ioctl( _fd, PERF_EVENT_IOC_RESET, 0 );
+                ioctl( _fd, PERF_EVENT_IOC_ENABLE, 0 );
+            }
+#endif
+        }
+
+        ~instruction_counter() {
+#ifdef __linux__
+            if (_fd >= 0)
+                close( _fd );
+#endif
+        }
+
+        bool available()const { return _fd >= 0; }
+
+        uint64_t read()const {
+            uint64_t count = 0;
+#ifdef __linux__
+            if (_fd >= 0 && ::read( _fd, &count, sizeof(count) ) != sizeof(count))
+                count = 0;
+#endif
+            return count;
+        }
+
+    private:
+        int _fd = -1;
+};
+
+std::map<std::string, int64_t> load_budgets( const std::string& path ) {
+    std::map<std::string, int64_t> budgets;
+    std::ifstream in( path );
+    if (!in) {
+        std::fprintf( stderr, "cannot read %s\n", path.c_str() );
+        std::exit( 1 );
+    }
+    std::string line;
+    while (std::getline( in, line )) {
+        line = line.substr( 0, line.find( '#' ) );
+        std::istringstream fields( line );
+        std::string key;
+        int64_t maximum;
+        if (fields >> key >> maximum)
+            budgets[key] = maximum;
+    }
+    return budgets;
+}
+
+bool read_leb128( const std::vector<uint8_t>& bytes, size_t& pos, uint64_t& value ) {
+    value = 0;
+    for (uint32_t shift = 0; pos < bytes.size() && shift < 64; shift += 7) {
+        const uint8_t b = bytes[pos++];
+        value |= uint64_t(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Bytes of every section of a WASM module, by section name, plus "total". Empty if it cannot be read.
+std::map<std::string, int64_t> wasm_sections( const std::string& path ) {
+    static const char* names[] = { "custom", "type", "import", "function", "table", "memory", "global",
+                                   "export", "start", "element", "code", "data" };
+    std::map<std::string, int64_t> sizes;
+    std::ifstream in( path, std::ios::binary );
+    const std::vector<uint8_t> bytes( (std::istreambuf_iterator<char>( in )), std::istreambuf_iterator<char>() );
+    if (bytes.size() < 8 || std::memcmp( bytes.data(), "\0asm", 4 ) != 0)
+        return sizes;
+
+    size_t pos = 8;
+    while (pos < bytes.size()) {
+        const uint8_t id = bytes[pos++];
+        uint64_t size;
+        if (!read_leb128( bytes, pos, size ) || pos + size > bytes.size())
+            return {};
+        sizes[ id < sizeof(names) / sizeof(names[0]) ? names[id] : "unknown" ] += size;
+        pos += size;
+    }
+    sizes["total"] = bytes.size();
+    return sizes;
+}
+
+struct action_cost {
+    uint64_t calls = 0;
+    uint64_t instructions = 0;
+};
+
+// FNV-1a hash of the UBI config and of the contents of "sources", in order, as 16 hex digits. Checkouts
+//   and copies keep it, unlike modification times.
+std::string sources_hash( const std::string& config, const std::vector<std::string>& sources ) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&]( const std::string& bytes ) {
+        for (const char b : bytes + '\0') {
+            hash ^= uint8_t(b);
+            hash *= 1099511628211ull;
+        }
+    };
+    mix( config );
+    for (const auto& source : sources) {
+        std::ifstream in( source, std::ios::binary );
+        if (!in) {
+            std::fprintf( stderr, "cannot read %s\n", source.c_str() );
+            std::exit( 1 );
+        }
+        mix( std::string( (std::istreambuf_iterator<char>( in )), std::istreambuf_iterator<char>() ) );
+    }
+    char hex[17];
+    std::snprintf( hex, sizeof(hex), "%016llx", (unsigned long long)hash );
+    return hex;
+}
+
+// The hash recorded next to "wasm" by --record-sources, or the empty string.
+std::string recorded_hash( const std::string& wasm ) {
+    std::ifstream in( wasm + ".sources" );
+    std::string hash;
+    in >> hash;
+    return hash;
+}
+
+// Sets the wasm.<section> budgets of the budgets file that has one to "sizes" plus 2%, keeping the rest
+//   of the file as it is.
+bool set_wasm_budgets( const std::string& path, const std::map<std::string, int64_t>& sizes ) {
+    std::ifstream in( path );
+    if (!in)
+        return false;
+    std::ostringstream out;
+    std::string line;
+    while (std::getline( in, line )) {
+        std::istringstream fields( line );
+        std::string key;
+        fields >> key;
+        auto it = key.compare( 0, 5, "wasm." ) == 0 ? sizes.find( key.substr( 5 ) ) : sizes.end();
+        if (it != sizes.end()) {
+            std::string padded = key;
+            padded.resize( std::max<size_t>( key.size() + 1, 20 ), ' ' );
+            line = padded + std::to_string( (it->second * 102 + 99) / 100 );
+        }
+        out << line << '\n';
+    }
+    in.close();
+    std::ofstream( path ) << out.str();
+    return true;
+}
+
+} /// namespace
+
+int main( int argc, char** argv ) {
+    std::string wasm_path;
+    std::string budgets_path;
+    std::vector<std::string> sources;
+    std::string config = "heart";
+    bool allow_stale_wasm = false;
+    bool allow_uncounted = false;
+    bool record_sources = false;
+    bool set_budgets = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp( argv[i], "--allow-stale-wasm" ))
+            allow_stale_wasm = true;
+        else if (!std::strcmp( argv[i], "--allow-uncounted" ))
+            allow_uncounted = true;
+        else if (!std::strcmp( argv[i], "--record-sources" ))
+            record_sources = true;
+        else if (!std::strcmp( argv[i], "--set-wasm-budgets" ))
+            set_budgets = true;
+        else if (i + 1 < argc && !std::strcmp( argv[i], "--config" ))
+            config = argv[++i];
+        else if (i + 1 < argc && !std::strcmp( argv[i], "--wasm" ))
+            wasm_path = argv[++i];
+        else if (i + 1 < argc && !std::strcmp( argv[i], "--source" ))
+            sources.push_back( argv[++i] );
+        else if (i + 1 < argc && !std::strcmp( argv[i], "--budgets" ))
+            budgets_path = argv[++i];
+        else {
+            std::fprintf( stderr, "unknown option %s\n", argv[i] );
+            return 1;
+        }
+    }
+    if ((record_sources || set_budgets) && wasm_path.empty()) {
+        std::fprintf( stderr, "--record-sources and --set-wasm-budgets need --wasm\n" );
+        return 1;
+    }
+    if (record_sources) {
+        const std::string hash = sources_hash( config, sources );
+        std::ofstream( wasm_path + ".sources" ) << hash << " " << config << "\n";
+        std::printf( "%s: built from sources %s (%s)\n", wasm_path.c_str(), hash.c_str(), config.c_str() );
+        return 0;
+    }
+    const auto budgets = budgets_path.empty() ? std::map<std::string, int64_t>() : load_budgets( budgets_path );
+
+    bool over = false;
+    bool unchecked = false;
+    auto check = [&]( const std::string& key, double value ) {
+        auto it = budgets.find( key );
+        if (it == budgets.end())
+            return std::string( "" );
+        if (value > it->second) {
+            over = true;
+            return "OVER " + std::to_string( it->second );
+        }
+        return "<= " + std::to_string( it->second );
+    };
+
+    if (!wasm_path.empty()) {
+        const auto sections = wasm_sections( wasm_path );
+        if (sections.empty()) {
+            std::fprintf( stderr, "%s is not a WASM module\n", wasm_path.c_str() );
+            return 1;
+        }
+        const std::string recorded = recorded_hash( wasm_path );
+        if (recorded != sources_hash( config, sources )) {
+            std::printf( "%s was %s: rebuild it with eosio-cpp (see scripts/deploy_contract.sh)%s\n\n", wasm_path.c_str(),
+                         recorded.empty() ? "built from unrecorded sources" : "built from other sources",
+                         allow_stale_wasm && !set_budgets ? ", checking it anyway" : "" );
+            if (set_budgets)
+                return 1;
+            unchecked = unchecked || !allow_stale_wasm;
+        }
+        if (set_budgets) {
+            if (!set_wasm_budgets( budgets_path, sections )) {
+                std::fprintf( stderr, "cannot read %s\n", budgets_path.c_str() );
+                return 1;
+            }
+            std::printf( "wasm budgets of %s set from %s\n", budgets_path.c_str(), wasm_path.c_str() );
+            return 0;
+        }
+        std::printf( "%-12s %10s\n", "section", "bytes" );
+        for (const auto& s : sections)
+            std::printf( "%-12s %10lld  %s\n", s.first.c_str(), (long long)s.second, check( "wasm." + s.first, s.second ).c_str() );
+        std::printf( "\n" );
+    }
+
+    // The scenario: holders open their balances, claim, pay each other one by one and in batches, are
+    //   queried, and those that cannot claim (every fourth) close; then the keeper audits and compacts.
+    native::chain& c = native::chain::instance();
+    token_driver token( c );
+    instruction_counter counter;
+    std::map<std::string, action_cost> costs;
+    auto measure = [&]( const char* action, auto&& push ) {
+        const uint64_t before = counter.read();
+        const native::push_result result = push();
+        if (!result) {
+            std::fprintf( stderr, "%s failed: %s\n", action, result.error.c_str() );
+            std::exit( 1 );
+        }
+        action_cost& cost = costs[action];
+        cost.instructions += counter.read() - before;
+        ++cost.calls;
+    };
+
+    const symbol heart( "HEART", 4 );
+    c.set_day( 18047 + 1000 );
+    token.create( token.contract(), asset{2100000000ll * 10000, heart} );
+
+    std::vector<name> holders;
+    for (uint32_t i = 0; i < 400; ++i) {
+        std::string s = "b";
+        for (uint32_t v = i, d = 0; d < 4; ++d, v /= 26)
+            s.push_back( char('a' + v % 26) );
+        holders.push_back( name( i % 4 == 3 ? s : s + ".jc" ) );
+    }
+
+    for (const auto& h : holders)
+        measure( "open", [&]() { return token.open( h, heart, h ); } );
+    c.advance_days( 1 );
+    for (size_t i = 0; i < holders.size(); ++i)
+        if (i % 4 != 3)
+            measure( "transfer", [&]() { return token.transfer( holders[i], holders[(i * 7 + 1) % holders.size()], asset{10000, heart}, "" ); } );
+    c.advance_days( 1 );
+    for (size_t i = 0; i < holders.size(); i += 40) {
+        std::vector<eosio::token::payment> payments;
+        for (size_t j = 0; j < 20; ++j)
+            payments.push_back( eosio::token::payment{ holders[(i + j + 1) % holders.size()], asset{100, heart}, "" } );
+        measure( "transfermany", [&]() { return token.transfermany( holders[i], payments ); } );
+    }
+    for (size_t i = 0; i < holders.size(); i += 20) {
+        std::vector<eosio::token::balance_query> queries;
+        for (size_t j = i; j < i + 20 && j < holders.size(); ++j)
+            queries.push_back( eosio::token::balance_query{ holders[j], heart.code() } );
+        measure( "getaccrued", [&]() { return token.getaccrued( queries ); } );
+    }
+    for (size_t i = 3; i < holders.size(); i += 4) {
+        const asset balance = token.balance( holders[i], heart );
+        if (balance.amount > 0)
+            measure( "transfer", [&]() { return token.transfer( holders[i], holders[0], balance, "" ); } );
+        measure( "close", [&]() { return token.close( holders[i], heart ); } );
+    }
+    std::vector<name> scopes = holders;
+    std::sort( scopes.begin(), scopes.end() );
+    for (size_t i = 0; i < scopes.size(); i += 50) {
+        const std::vector<name> chunk( scopes.begin() + i, scopes.begin() + std::min( i + 50, scopes.size() ) );
+        measure( "maintain", [&]() { return token.maintain( heart.code(), eosio::token::audit_pass, i == 0, chunk, 200 ); } );
+    }
+    measure( "compact", [&]() { return token.compact( heart.code() ); } );
+
+    if (!counter.available()) {
+        const bool budgeted = std::any_of( budgets.begin(), budgets.end(), []( const auto& b ) {
+            const std::string suffix = ".instructions";
+            return b.first.size() > suffix.size() && b.first.compare( b.first.size() - suffix.size(), suffix.size(), suffix ) == 0;
+        });
+        std::printf( "instruction counts unavailable (perf_event_open failed), their budgets are not checked\n\n" );
+        unchecked = unchecked || (budgeted && !allow_uncounted);
+    }
+
+    std::printf( "%-13s %6s %13s %8s %8s %8s\n", "action", "calls", "instructions", "reads", "writes", "inlines" );
+    for (const auto& a : costs) {
+        const std::string& act = a.first;
+        const auto& st = c.stats[ name( act ).value ];
+        const double n = st.count ? double(st.count) : 1.0;
+        const double instructions = a.second.calls ? double(a.second.instructions) / a.second.calls : 0.0;
+        const std::string shown = counter.available() ? std::to_string( std::llround( instructions ) ) : "-";
+        std::printf( "%-13s %6llu %13s %8.2f %8.2f %8.2f\n", act.c_str(), (unsigned long long)a.second.calls,
+                     shown.c_str(), st.db_reads / n, st.db_writes / n, st.inline_actions / n );
+        if (counter.available()) {
+            const std::string verdict = check( act + ".instructions", instructions );
+            if (!verdict.empty())
+                std::printf( "  %-24s %s\n", (act + ".instructions").c_str(), verdict.c_str() );
+        }
+        for (const auto& cost : { std::make_pair( "reads", st.db_reads / n ), std::make_pair( "writes", st.db_writes / n ),
+                                  std::make_pair( "inlines", st.inline_actions / n ) }) {
+            const std::string verdict = check( act + "." + cost.first, cost.second );
+            if (!verdict.empty())
+                std::printf( "  %-24s %s\n", (act + "." + cost.first).c_str(), verdict.c_str() );
+        }
+    }
+
+    if (over) {
+        std::printf( "\nover budget\n" );
+        return 1;
+    }
+    if (unchecked) {
+        std::printf( "\nbudgets not checked (pass --allow-stale-wasm or --allow-uncounted to accept that)\n" );
+        return 1;
+    }
+    return 0;
+}
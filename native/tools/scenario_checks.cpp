@@ -0,0 +1,705 @@
+/**
+ * Scenario checks of the revelation21 contract on the native chain.
+ *
+ * Every check starts from an empty chain, pushes a short fixed scenario and checks what it leaves
+ *   behind. They cover the paths the random sequences of token_fuzz.cpp do not reach, such as the
+ *   rows left by older versions of the contract, which no action writes anymore and are seeded here
+ *   directly. The native chain bills RAM as nodeos does, so an action that grows a row paid by an
+ *   account that did not authorize it fails here as it would on chain.
+ *
+ *   revelation21_checks [--verbose] [CHECK...]
+ *
+ * Runs every check, or the named ones, and exits with 1 if any fails. Most checks are written for the
+ *   HEART schedule; the checks of another UBI schedule run in the driver built for it
+ *   (revelation21_checks_open_chain, ...), along with those that hold under every schedule.
+ */
+
+#include "token_driver.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace eosio;
+using revelation21::token_driver;
+using native::push_result;
+
+namespace {
+
+const name contract_account = "revelation21"_n;
+const symbol heart( "HEART", 4 );
+constexpr int64_t unit = 10000;
+constexpr uint32_t start_day = 18047 + 1000;
+// What a table costs its first payer, as long as it has rows.
+constexpr int64_t table_overhead = native::billable_table_overhead;
+
+// The UBI schedule the contract is built with (see UBI_CONFIG).
+typedef ubi_config::UBI_CONFIG schedule;
+
+template <typename Config>
+constexpr bool built_for = std::is_same<schedule, Config>::value;
+
+constexpr bool every_schedule = true;
+
+bool verbose = false;
+
+struct check_failure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+#define CHECK( cond, ... ) \
+    do { if (!(cond)) fail( __LINE__, __VA_ARGS__ ); } while (0)
+
+template <typename... Args>
+[[noreturn]] void fail( int line, const char* format, Args... args ) {
+    char buf[512];
+    int n = std::snprintf( buf, sizeof(buf), "line %d: ", line );
+    std::snprintf( buf + n, sizeof(buf) - n, format, args... );
+    throw check_failure( buf );
+}
+
+// The chain of a check: a HEART token created by the contract, on day "start_day".
+struct fixture {
+    native::chain&  c;
+    token_driver    token;
+
+    fixture() : c( native::chain::instance() ), token( (c.reset(), c), contract_account ) {
+        c.set_day( start_day );
+        CHECK( token.create( contract_account, asset{2100000000ll * unit, heart} ), "create failed" );
+    }
+
+    void expect_ok( const push_result& r, const char* what ) {
+        if (verbose)
+            std::printf( "  %s: %s\n", what, r ? "ok" : r.error.c_str() );
+        CHECK( r, "%s failed: %s", what, r.error.c_str() );
+    }
+
+    void expect_fail( const push_result& r, const char* what, const char* error ) {
+        if (verbose)
+            std::printf( "  %s: %s\n", what, r ? "ok" : r.error.c_str() );
+        CHECK( !r, "%s succeeded", what );
+        CHECK( r.error.find( error ) != std::string::npos, "%s failed with \"%s\", not \"%s\"", what, r.error.c_str(), error );
+    }
+
+    void seed_legacy( name owner, int64_t balance, name payer, eosio::token::time_type claim_day, bool balance_row = true ) {
+        token.seed_legacy( owner, asset{balance, heart}, payer, claim_day, balance_row );
+    }
+
+    bool has_extras( name owner ) {
+        return c.run_as( contract_account, {}, [&]() {
+            eosio::token::legacy_extras_table xtrs( contract_account, owner.value );
+            return xtrs.find( heart.code().raw() ) != xtrs.end();
+        });
+    }
+
+    // The claim day of the balance row of "owner", or 0 if it has none.
+    eosio::token::time_type claim_day( name owner ) {
+        return c.run_as( contract_account, {}, [&]() -> eosio::token::time_type {
+            eosio::token::balance_table acnts( contract_account, owner.value );
+            auto it = acnts.find( heart.code().raw() );
+            return it != acnts.end() ? it->last_claim_day.value_or() : 0;
+        });
+    }
+
+    int64_t ram_of( name account ) {
+        auto it = c.db.ram_usage.find( account.value );
+        return it != c.db.ram_usage.end() ? it->second : 0;
+    }
+
+    // The balances add up to the supply, and the liability aggregates count every row with a claim day.
+    void check_totals( std::initializer_list<name> owners ) {
+        int64_t sum = 0;
+        uint64_t ubi_rows = 0;
+        for (name owner : owners) {
+            sum += token.balance( owner, heart ).amount;
+            ubi_rows += claim_day( owner ) != 0;
+        }
+        const int64_t supply = token.supply( heart ).amount;
+        CHECK( sum == supply, "balances add up to %lld, the supply is %lld", (long long)sum, (long long)supply );
+        const auto liability = token.liability( heart );
+        CHECK( liability.ubi_accounts == ubi_rows, "the stat row counts %llu UBI accounts, there are %llu",
+               (unsigned long long)liability.ubi_accounts, (unsigned long long)ubi_rows );
+    }
+};
+
+// migrate() moves the claim days of legacy rows into their balance rows with only the contract's
+//   authority, whoever paid for the rows, drops orphaned extras rows, and resumes from its cursor.
+void migrate_legacy_rows() {
+    fixture f;
+    const auto day = eosio::token::time_type( start_day - 10 );
+    f.seed_legacy( "alice.jc"_n, 0, "alice.jc"_n, day );
+    f.seed_legacy( "bob.jc"_n, 0, "sponsor"_n, day - 1 );
+    f.seed_legacy( "carol.jc"_n, 0, "carol.jc"_n, day, false );
+
+    f.expect_ok( f.token.migrate( heart.code(), { "alice.jc"_n, "bob.jc"_n, "carol.jc"_n } ), "migrate" );
+    CHECK( f.claim_day( "alice.jc"_n ) == day, "alice.jc has claim day %u", unsigned(f.claim_day( "alice.jc"_n )) );
+    CHECK( f.claim_day( "bob.jc"_n ) == day - 1, "bob.jc has claim day %u", unsigned(f.claim_day( "bob.jc"_n )) );
+    for (name owner : { "alice.jc"_n, "bob.jc"_n, "carol.jc"_n })
+        CHECK( !f.has_extras( owner ), "%s still has an extras row", owner.to_string().c_str() );
+    // The grown rows are the contract's now, and their payers are only left with the tables they created.
+    CHECK( f.ram_of( "sponsor"_n ) == table_overhead && f.ram_of( "alice.jc"_n ) == table_overhead,
+           "the owners still pay for migrated rows" );
+    const auto dormant = f.token.dormant( heart, 0, 0xFFFF, 10 );
+    CHECK( schedule::index_claim_days ? dormant.size() == 2 && dormant[0].owner == "bob.jc"_n : dormant.empty(),
+           "the claim index has %zu rows", dormant.size() );
+    f.check_totals( { "alice.jc"_n, "bob.jc"_n, "carol.jc"_n } );
+
+    // A chunk pushed again is skipped.
+    f.seed_legacy( "alice.jc"_n, 0, "alice.jc"_n, day, false );
+    f.expect_ok( f.token.migrate( heart.code(), { "alice.jc"_n } ), "migrate again" );
+    CHECK( f.has_extras( "alice.jc"_n ), "an owner at the cursor was migrated again" );
+}
+
+// The first transfer of a legacy UBI row migrates it, and the sender pays for the claim day, even when
+//   the row was opened by whoever first sent it tokens.
+void migrate_on_transfer() {
+    fixture f;
+    f.seed_legacy( "dan.jc"_n, 0, "sponsor"_n, eosio::token::time_type( start_day - 10 ) );
+    f.expect_ok( f.token.open( "erin"_n, heart, "erin"_n ), "open erin" );
+
+    f.expect_ok( f.token.transfer( "dan.jc"_n, "erin"_n, asset{unit, heart}, "" ), "transfer dan.jc" );
+    // Nine days of back pay and today's.
+    CHECK( f.token.balance( "dan.jc"_n, heart ).amount == 9 * unit, "dan.jc has %lld", (long long)f.token.balance( "dan.jc"_n, heart ).amount );
+    CHECK( f.claim_day( "dan.jc"_n ) == start_day, "dan.jc has claim day %u", unsigned(f.claim_day( "dan.jc"_n )) );
+    CHECK( !f.has_extras( "dan.jc"_n ), "dan.jc still has an extras row" );
+    CHECK( f.ram_of( "sponsor"_n ) == table_overhead && f.ram_of( "dan.jc"_n ) > 0, "dan.jc does not pay for its row" );
+    f.check_totals( { "dan.jc"_n, "erin"_n } );
+}
+
+// open() of a legacy row by a sponsor migrates it at the sponsor's expense. A row opened before its owner
+//   could claim has no extras row, and starts from the first claim day.
+void migrate_on_open() {
+    fixture f;
+    f.seed_legacy( "frank.jc"_n, 0, "frank.jc"_n, eosio::token::time_type( start_day - 3 ) );
+    f.seed_legacy( "gina.jc"_n, 0, "gina.jc"_n, 0 );
+
+    f.expect_ok( f.token.open( "frank.jc"_n, heart, "sponsor"_n ), "open frank.jc" );
+    CHECK( f.token.balance( "frank.jc"_n, heart ).amount == 3 * unit, "frank.jc has %lld", (long long)f.token.balance( "frank.jc"_n, heart ).amount );
+    CHECK( f.ram_of( "frank.jc"_n ) == table_overhead && f.ram_of( "sponsor"_n ) > 0, "the sponsor does not pay for the row" );
+
+    f.expect_ok( f.token.open( "gina.jc"_n, heart, "gina.jc"_n ), "open gina.jc" );
+    CHECK( f.claim_day( "gina.jc"_n ) == start_day, "gina.jc has claim day %u", unsigned(f.claim_day( "gina.jc"_n )) );
+    f.check_totals( { "frank.jc"_n, "gina.jc"_n } );
+}
+
+// close() of a legacy row takes its extras row with it, unless today's income has been claimed.
+void close_legacy_row() {
+    fixture f;
+    f.seed_legacy( "hank.jc"_n, 0, "hank.jc"_n, eosio::token::time_type( start_day - 1 ) );
+    f.seed_legacy( "ivy.jc"_n, 0, "ivy.jc"_n, eosio::token::time_type( start_day ) );
+
+    f.expect_ok( f.token.close( "hank.jc"_n, heart ), "close hank.jc" );
+    CHECK( !f.has_extras( "hank.jc"_n ), "hank.jc still has an extras row" );
+    CHECK( f.ram_of( "hank.jc"_n ) == 0, "hank.jc still pays for %lld bytes", (long long)f.ram_of( "hank.jc"_n ) );
+
+    f.expect_fail( f.token.close( "ivy.jc"_n, heart ), "close ivy.jc", "income was already claimed for today" );
+    CHECK( f.has_extras( "ivy.jc"_n ), "the failed close erased the extras row" );
+}
+
+// The cleanup pass of maintain() erases extras rows that are orphaned or superseded by a claim day in the
+//   balance row, and leaves those still waiting to be migrated.
+void cleanup_pass() {
+    fixture f;
+    const auto day = eosio::token::time_type( start_day - 5 );
+    f.seed_legacy( "jack.jc"_n, 0, "jack.jc"_n, day, false );
+    f.expect_ok( f.token.open( "kate.jc"_n, heart, "kate.jc"_n ), "open kate.jc" );
+    f.seed_legacy( "kate.jc"_n, 0, "kate.jc"_n, day, false );
+    f.seed_legacy( "liam.jc"_n, 0, "liam.jc"_n, day );
+
+    f.expect_ok( f.token.maintain( heart.code(), eosio::token::cleanup_pass, true, { "jack.jc"_n, "kate.jc"_n, "liam.jc"_n }, 100 ),
+                 "maintain cleanup" );
+    CHECK( !f.has_extras( "jack.jc"_n ), "the orphaned extras row is left" );
+    CHECK( !f.has_extras( "kate.jc"_n ), "the superseded extras row is left" );
+    CHECK( f.has_extras( "liam.jc"_n ), "the extras row of a row to migrate was erased" );
+    CHECK( f.claim_day( "kate.jc"_n ) == start_day, "the cleanup changed the claim day of kate.jc" );
+}
+
+// The migrate pass of maintain() moves claim days with only the contract's authority (as a keeper runs it,
+//   through a permission of the contract), whoever paid for the rows, and resumes from its cursor.
+void migrate_pass() {
+    fixture f;
+    const auto day = eosio::token::time_type( start_day - 10 );
+    const std::vector<name> owners = { "mia.jc"_n, "ned.jc"_n, "ola.jc"_n, "pat"_n, "quin.jc"_n };
+    f.seed_legacy( "mia.jc"_n, 0, "mia.jc"_n, day );
+    f.seed_legacy( "ned.jc"_n, 0, "sponsor"_n, day + 1 );
+    f.expect_ok( f.token.open( "ola.jc"_n, heart, "ola.jc"_n ), "open ola.jc" );
+    f.expect_ok( f.token.open( "pat"_n, heart, "pat"_n ), "open pat" );
+    f.seed_legacy( "quin.jc"_n, 0, "quin.jc"_n, day + 2 );
+
+    // A budget of 3 rows stops the first call after the first migrated owner.
+    f.expect_ok( f.token.maintain( heart.code(), eosio::token::migrate_pass, true, owners, 3 ), "maintain migrate" );
+    CHECK( f.claim_day( "mia.jc"_n ) == day && f.has_extras( "ned.jc"_n ), "the first call did not stop at its budget" );
+    f.expect_ok( f.token.maintain( heart.code(), eosio::token::migrate_pass, false, owners, 100 ), "maintain migrate again" );
+    CHECK( f.claim_day( "ned.jc"_n ) == day + 1 && f.claim_day( "quin.jc"_n ) == day + 2, "the second call did not migrate the rest" );
+    for (name owner : owners)
+        CHECK( !f.has_extras( owner ), "%s still has an extras row", owner.to_string().c_str() );
+    CHECK( f.ram_of( "sponsor"_n ) == table_overhead && f.ram_of( "mia.jc"_n ) == table_overhead,
+           "the owners still pay for migrated rows" );
+    CHECK( f.token.dormant( heart, 0, 0xFFFF, 10 ).size() == (schedule::index_claim_days ? 4 : 0),
+           "the migrated rows are not in the claim index" );
+    f.check_totals( { "mia.jc"_n, "ned.jc"_n, "ola.jc"_n, "pat"_n, "quin.jc"_n } );
+
+    // The migrated rows then claim as any other.
+    f.expect_ok( f.token.open( "ned.jc"_n, heart, "ned.jc"_n ), "open ned.jc" );
+    CHECK( f.token.balance( "ned.jc"_n, heart ).amount == 9 * unit, "ned.jc has %lld", (long long)f.token.balance( "ned.jc"_n, heart ).amount );
+}
+
+// The liability aggregates of the stat row itself, without those of the supply shards.
+struct aggregates {
+    int64_t ubi_accounts;
+    int64_t claim_day_sum;
+};
+
+aggregates stat_row_aggregates( fixture& f ) {
+    return f.c.run_as( contract_account, {}, [&]() {
+        eosio::token::stat_table stats( contract_account, heart.code().raw() );
+        const auto& st = stats.get( heart.code().raw() );
+        return aggregates{ int64_t( st.ubi_accounts.value_or() ), int64_t( st.claim_day_sum.value_or() ) };
+    });
+}
+
+// The UBI accounts that open(), transfermany() and migrate() add are counted in the supply shards of
+//   their owners, not in the stat row that every transfer reads.
+void shard_aggregates() {
+    fixture f;
+    f.expect_ok( f.token.issue( contract_account, asset{1000 * unit, heart}, "" ), "issue" );
+    const auto before = stat_row_aggregates( f );
+
+    f.expect_ok( f.token.open( "rae.jc"_n, heart, "rae.jc"_n ), "open rae.jc" );
+    f.expect_ok( f.token.transfermany( contract_account, {
+                     eosio::token::payment{ "sam.jc"_n, asset{unit, heart}, "" },
+                     eosio::token::payment{ "tom.jc"_n, asset{unit, heart}, "" },
+                     eosio::token::payment{ "uma"_n, asset{unit, heart}, "" } } ), "transfermany" );
+    f.seed_legacy( "val.jc"_n, 0, "val.jc"_n, eosio::token::time_type( start_day - 2 ) );
+    f.expect_ok( f.token.migrate( heart.code(), { "val.jc"_n } ), "migrate" );
+    f.seed_legacy( "wes.jc"_n, 0, "wes.jc"_n, eosio::token::time_type( start_day - 2 ) );
+    f.expect_ok( f.token.maintain( heart.code(), eosio::token::migrate_pass, true, { "wes.jc"_n }, 10 ), "maintain migrate" );
+
+    const auto after = stat_row_aggregates( f );
+    CHECK( after.ubi_accounts == before.ubi_accounts && after.claim_day_sum == before.claim_day_sum,
+           "the stat row counts %lld UBI accounts, it counted %lld", (long long)after.ubi_accounts, (long long)before.ubi_accounts );
+    f.check_totals( { contract_account, "rae.jc"_n, "sam.jc"_n, "tom.jc"_n, "uma"_n, "val.jc"_n, "wes.jc"_n } );
+
+    f.expect_ok( f.token.compact( heart.code() ), "compact" );
+    CHECK( stat_row_aggregates( f ).ubi_accounts == 5, "compact folded %lld UBI accounts into the stat row",
+           (long long)stat_row_aggregates( f ).ubi_accounts );
+    f.check_totals( { contract_account, "rae.jc"_n, "sam.jc"_n, "tom.jc"_n, "uma"_n, "val.jc"_n, "wes.jc"_n } );
+}
+
+// retire() takes the claims minted by the supply shards into the stat row before debiting it, so that
+//   the supply "cleos get currency stats" shows never goes below zero.
+void retire_stat_row() {
+    fixture f;
+    f.expect_ok( f.token.open( "ivy.jc"_n, heart, "ivy.jc"_n ), "open ivy.jc" );
+    f.expect_ok( f.token.issue( contract_account, asset{100 * unit, heart}, "" ), "issue" );
+    f.expect_ok( f.token.transfer( "ivy.jc"_n, contract_account, asset{500 * unit, heart}, "" ), "transfer" );
+    f.expect_ok( f.token.retire( contract_account, asset{600 * unit, heart}, "" ), "retire" );
+
+    const int64_t supply = f.token.supply( heart ).amount;
+    const int64_t stat_supply = f.token.stat_supply( heart ).amount;
+    CHECK( stat_supply == supply, "the stat row supply is %lld, the supply is %lld", (long long)stat_supply, (long long)supply );
+    f.check_totals( { contract_account, "ivy.jc"_n } );
+}
+
+// A token created before the supply shards existed has none: claims fail until compact() creates them
+//   with their allowances, rather than paying nothing from empty shards.
+void missing_shards() {
+    fixture f;
+    f.c.run_as( contract_account, {}, [&]() {
+        eosio::token::supply_shard_table shards( contract_account, heart.code().raw() );
+        for (auto it = shards.begin(); it != shards.end(); )
+            it = shards.erase( it );
+    });
+    f.expect_fail( f.token.open( "xia.jc"_n, heart, "xia.jc"_n ), "open without shards", "run compact()" );
+    f.expect_ok( f.token.open( "yan"_n, heart, "yan"_n ), "open of an account that cannot claim" );
+
+    f.expect_ok( f.token.compact( heart.code() ), "compact" );
+    f.c.advance_days( 1 );
+    f.expect_ok( f.token.open( "xia.jc"_n, heart, "xia.jc"_n ), "open xia.jc" );
+    CHECK( f.token.balance( "xia.jc"_n, heart ).amount > 0, "xia.jc was paid nothing" );
+}
+
+// close() counts closed holders only while the token keeps metrics, which it tells from the metrics
+//   table alone; the row setmetrics() leaves for today is not reported as a day of activity.
+void metrics_on_close() {
+    fixture f;
+    f.expect_ok( f.token.open( "zoe"_n, heart, "zoe"_n ), "open zoe" );
+    f.expect_ok( f.token.close( "zoe"_n, heart ), "close zoe without metrics" );
+
+    f.expect_ok( f.token.setmetrics( heart.code(), 30 ), "setmetrics 30" );
+    CHECK( f.token.metrics( heart ).empty(), "setmetrics reports %zu days of activity", f.token.metrics( heart ).size() );
+    f.expect_ok( f.token.open( "zoe"_n, heart, "zoe"_n ), "open zoe again" );
+    f.expect_ok( f.token.close( "zoe"_n, heart ), "close zoe with metrics" );
+    auto days = f.token.metrics( heart );
+    CHECK( days.size() == 1 && days[0].day == start_day && days[0].closed_holders == 1 && days[0].new_holders == 1,
+           "the metrics have %zu days", days.size() );
+
+    f.expect_ok( f.token.setmetrics( heart.code(), 0 ), "setmetrics 0" );
+    f.expect_ok( f.token.open( "zoe"_n, heart, "zoe"_n ), "open zoe once more" );
+    f.expect_ok( f.token.close( "zoe"_n, heart ), "close zoe after metrics" );
+    const bool kept = f.c.run_as( contract_account, {}, [&]() {
+        eosio::token::metrics_table buckets( contract_account, heart.code().raw() );
+        return buckets.begin() != buckets.end();
+    });
+    CHECK( !kept && f.token.metrics( heart ).empty(), "metrics are still kept" );
+}
+
+// Whether a transfer from "from" to "to" notifies "account".
+bool notifies( fixture& f, name from, name to, name account ) {
+    f.c.tracing = true;
+    f.expect_ok( f.token.transfer( from, to, asset{1, heart}, "" ), "transfer" );
+    f.c.tracing = false;
+    const auto& notified = f.c.trace.notified;
+    return std::find( notified.begin(), notified.end(), account ) != notified.end();
+}
+
+// The notification filter of the stat row: its size in bytes and the number of bits it has set, or
+//   -1 and 0 without a filter.
+std::pair<int, int> notify_filter( fixture& f ) {
+    return f.c.run_as( contract_account, {}, [&]() {
+        eosio::token::stat_table stats( contract_account, heart.code().raw() );
+        const auto& st = stats.get( heart.code().raw() );
+        if (!st.notify_filter.has_value())
+            return std::make_pair( -1, 0 );
+        int bits = 0;
+        for (uint8_t b : *st.notify_filter)
+            bits += __builtin_popcount( b );
+        return std::make_pair( int( st.notify_filter->size() ), bits );
+    });
+}
+
+// setnotify() modes: notified of every transfer, of incoming ones only, or of none, and back. compact()
+//   rebuilds the filter from the accounts that are still registered.
+void notify_modes() {
+    fixture f;
+    f.expect_ok( f.token.issue( "amy"_n, asset{100 * unit, heart}, "" ), "issue" );
+    f.expect_ok( f.token.transfer( "amy"_n, "ben"_n, asset{10 * unit, heart}, "" ), "transfer to ben" );
+    CHECK( notifies( f, "amy"_n, "ben"_n, "ben"_n ) && notifies( f, "ben"_n, "amy"_n, "ben"_n ), "ben is not notified by default" );
+
+    f.expect_ok( f.token.setnotify( "ben"_n, heart.code(), eosio::token::notify_incoming ), "setnotify incoming" );
+    CHECK( notifies( f, "amy"_n, "ben"_n, "ben"_n ), "ben is not notified of incoming transfers" );
+    CHECK( !notifies( f, "ben"_n, "amy"_n, "ben"_n ), "ben is notified of outgoing transfers" );
+    CHECK( notifies( f, "ben"_n, "amy"_n, "amy"_n ), "amy is not notified any more" );
+
+    f.expect_ok( f.token.setnotify( "ben"_n, heart.code(), eosio::token::notify_none ), "setnotify none" );
+    CHECK( !notifies( f, "amy"_n, "ben"_n, "ben"_n ) && !notifies( f, "ben"_n, "amy"_n, "ben"_n ), "ben is still notified" );
+
+    f.expect_ok( f.token.setnotify( "ben"_n, heart.code(), eosio::token::notify_all ), "setnotify all" );
+    CHECK( notifies( f, "amy"_n, "ben"_n, "ben"_n ) && notifies( f, "ben"_n, "amy"_n, "ben"_n ), "ben is not notified again" );
+    f.expect_fail( f.token.setnotify( "ben"_n, heart.code(), eosio::token::notify_all ), "setnotify all twice", "already notified" );
+    f.expect_fail( f.token.setnotify( "ben"_n, heart.code(), eosio::token::notify_modes ), "setnotify 3", "invalid notification mode" );
+
+    // Ben's bits stay until compact(), which drops the filter without any account left.
+    CHECK( notify_filter( f ).first == 8 && notify_filter( f ).second > 0, "setnotify left a filter of %d bytes", notify_filter( f ).first );
+    f.expect_ok( f.token.compact( heart.code() ), "compact" );
+    CHECK( notify_filter( f ).first == -1, "compact left a filter of %d bytes", notify_filter( f ).first );
+
+    // A filter filled by many accounts is sized for them, and only keeps those still registered.
+    std::vector<name> accounts;
+    for (char c = 'a'; c <= 'z'; ++c) {
+        for (char d = 'a'; d <= 'e'; ++d) {
+            accounts.push_back( name( std::string( "reg" ) + c + d ) );
+            f.expect_ok( f.token.setnotify( accounts.back(), heart.code(), eosio::token::notify_none ), "setnotify none" );
+        }
+    }
+    const int full = notify_filter( f ).second;
+    CHECK( full > 60, "130 accounts set %d bits of the filter", full );
+    f.expect_ok( f.token.compact( heart.code() ), "compact" );
+    CHECK( notify_filter( f ).first == 256, "the filter of 130 accounts has %d bytes", notify_filter( f ).first );
+    for (size_t i = 1; i < accounts.size(); ++i)
+        f.expect_ok( f.token.setnotify( accounts[i], heart.code(), eosio::token::notify_all ), "setnotify all" );
+    f.expect_ok( f.token.compact( heart.code() ), "compact" );
+    CHECK( notify_filter( f ).first == 8 && notify_filter( f ).second <= 2, "the filter of one account has %d bytes and %d bits",
+           notify_filter( f ).first, notify_filter( f ).second );
+    f.expect_ok( f.token.open( accounts[0], heart, accounts[0] ), "open" );
+    CHECK( !notifies( f, "amy"_n, accounts[0], accounts[0] ), "the account left in the filter is notified" );
+}
+
+// The batch actions take their owners in ascending order and fail on any other, since an owner out of
+//   order would be taken for one done by a previous chunk. Chunks pushed again are still skipped.
+void unsorted_owners() {
+    fixture f;
+    f.expect_fail( f.token.openmany( "sponsor"_n, heart, 1, { "zed.jc"_n, "amy.jc"_n } ), "openmany unsorted", "sorted" );
+    f.expect_fail( f.token.openmany( "sponsor"_n, heart, 1, { "amy.jc"_n, "amy.jc"_n } ), "openmany twice", "sorted" );
+    f.expect_ok( f.token.openmany( "sponsor"_n, heart, 1, { "amy.jc"_n, "zed.jc"_n } ), "openmany" );
+    f.expect_ok( f.token.openmany( "sponsor"_n, heart, 1, { "amy.jc"_n, "bob.jc"_n, "zed.jc"_n } ), "openmany again" );
+    CHECK( f.claim_day( "amy.jc"_n ) != 0 && f.claim_day( "zed.jc"_n ) != 0, "an owner was not opened" );
+    CHECK( f.claim_day( "bob.jc"_n ) == 0, "an owner below the cursor was opened" );
+
+    f.seed_legacy( "cid.jc"_n, 0, "cid.jc"_n, eosio::token::time_type( start_day - 1 ) );
+    f.seed_legacy( "dee.jc"_n, 0, "dee.jc"_n, eosio::token::time_type( start_day - 1 ) );
+    f.expect_fail( f.token.migrate( heart.code(), { "dee.jc"_n, "cid.jc"_n } ), "migrate unsorted", "sorted" );
+    f.expect_fail( f.token.maintain( heart.code(), eosio::token::migrate_pass, true, { "dee.jc"_n, "cid.jc"_n }, 100 ),
+                   "maintain unsorted", "sorted" );
+    f.expect_ok( f.token.migrate( heart.code(), { "cid.jc"_n, "dee.jc"_n } ), "migrate" );
+    CHECK( !f.has_extras( "cid.jc"_n ) && !f.has_extras( "dee.jc"_n ), "an owner was not migrated" );
+}
+
+// The "claimindex" row a claim adds for a holder that has none, because its row was migrated from the
+//   "extras" table or opened before the index existed, is billed to the claimant, not to the contract.
+void index_row_payer() {
+    fixture f;
+    for (name owner : { "leg.jc"_n, "pre.jc"_n })
+        f.expect_ok( f.token.setelig( owner, eligibility::allowed ), "allow" );
+    f.expect_ok( f.token.open( "pre.jc"_n, heart, "pre.jc"_n ), "open pre.jc" );
+    f.c.run_as( contract_account, {}, [&]() {
+        eosio::token::claim_index_table index( contract_account, heart.code().raw() );
+        auto it = index.find( "pre.jc"_n.value );
+        if (it != index.end())
+            index.erase( it );
+    });
+    f.seed_legacy( "leg.jc"_n, 0, "leg.jc"_n, eosio::token::time_type( start_day - 5 ) );
+    // Past the days paid in advance, and the grace period, so that both claim.
+    f.c.advance_days( 40 );
+
+    const int64_t contract_ram = f.ram_of( contract_account );
+    f.expect_ok( f.token.transfer( "leg.jc"_n, "bank"_n, asset{unit, heart}, "" ), "transfer from leg.jc" );
+    f.expect_ok( f.token.transfer( "pre.jc"_n, "bank"_n, asset{unit, heart}, "" ), "transfer from pre.jc" );
+    CHECK( f.ram_of( contract_account ) == contract_ram, "the contract pays %lld more bytes",
+           (long long)(f.ram_of( contract_account ) - contract_ram) );
+
+    const auto indexed = f.c.run_as( contract_account, {}, [&]() {
+        eosio::token::claim_index_table index( contract_account, heart.code().raw() );
+        return std::make_pair( index.find( "leg.jc"_n.value ) != index.end(), index.find( "pre.jc"_n.value ) != index.end() );
+    });
+    CHECK( indexed.first == schedule::index_claim_days && indexed.second == schedule::index_claim_days,
+           "the claims left leg.jc %s and pre.jc %s", indexed.first ? "indexed" : "not indexed",
+           indexed.second ? "indexed" : "not indexed" );
+    f.check_totals( { "leg.jc"_n, "pre.jc"_n, "bank"_n } );
+}
+
+// What opening balances for "owners" left behind: the balance row and "claimindex" row of each owner,
+//   every supply shard, and the claim logs sent.
+struct opened_rows {
+    std::vector<std::array<int64_t, 3>>  owners;     // balance, claim day and indexed claim day (0 if none)
+    std::vector<std::array<int64_t, 5>>  shards;     // id, minted, allowance, UBI accounts and claim day sum
+    std::vector<std::pair<uint64_t, std::vector<char>>> logs;
+
+    bool operator==( const opened_rows& o )const { return owners == o.owners && shards == o.shards && logs == o.logs; }
+};
+
+opened_rows rows_of( fixture& f, const std::vector<name>& owners ) {
+    opened_rows rows;
+    f.c.run_as( contract_account, {}, [&]() {
+        eosio::token::claim_index_table index( contract_account, heart.code().raw() );
+        for (name owner : owners) {
+            auto it = index.find( owner.value );
+            rows.owners.push_back( { f.token.balance( owner, heart ).amount, f.claim_day( owner ),
+                                     it != index.end() ? it->last_claim_day : 0 } );
+        }
+        eosio::token::supply_shard_table shards( contract_account, heart.code().raw() );
+        for (const auto& s : shards)
+            rows.shards.push_back( { int64_t(s.id), s.minted.amount, s.allowance.amount, s.ubi_accounts, s.claim_day_sum } );
+    });
+    return rows;
+}
+
+// openmany() leaves the same rows as open() of every owner followed by its first claim, paid by the
+//   sponsor, and logs the same claims (under a schedule with log_ubi_claims).
+void openmany_rows() {
+    std::vector<name> owners = { "amy.jc"_n, "bob"_n, "cat.jc"_n, "dan"_n, contract_account };
+    std::sort( owners.begin(), owners.end() );
+    auto setup = [&]( fixture& f ) {
+        f.expect_ok( f.token.setelig( "amy.jc"_n, eligibility::allowed ), "allow amy.jc" );
+        f.expect_ok( f.token.setelig( "dan"_n, eligibility::allowed ), "allow dan" );
+        f.c.tracing = true;
+    };
+
+    opened_rows opened;
+    {
+        fixture f;
+        setup( f );
+        for (name owner : owners) {
+            f.expect_ok( f.token.open( owner, heart, "sponsor"_n ), "open" );
+            for (const auto& act : f.c.trace.inlines)
+                opened.logs.emplace_back( act.name.value, act.data );
+        }
+        f.c.tracing = false;
+        const opened_rows rows = rows_of( f, owners );
+        opened.owners = rows.owners;
+        opened.shards = rows.shards;
+        f.check_totals( { "amy.jc"_n, "bob"_n, "cat.jc"_n, "dan"_n, contract_account } );
+    }
+
+    fixture f;
+    setup( f );
+    f.expect_ok( f.token.openmany( "sponsor"_n, heart, 1, owners ), "openmany" );
+    opened_rows batch = rows_of( f, owners );
+    for (const auto& act : f.c.trace.inlines)
+        batch.logs.emplace_back( act.name.value, act.data );
+    f.c.tracing = false;
+    f.check_totals( { "amy.jc"_n, "bob"_n, "cat.jc"_n, "dan"_n, contract_account } );
+
+    int64_t claims = 0;
+    for (const auto& owner : batch.owners)
+        claims += owner[0] > 0;
+    // With the grace period of free account creation, new rows are not paid yet.
+    const int64_t paid_owners = schedule::unbounded_UBI_account_creation ? 0 : 2;
+    CHECK( claims == paid_owners, "%lld owners were paid a claim, not %lld", (long long)claims, (long long)paid_owners );
+    CHECK( batch.logs.size() == (schedule::log_ubi_claims ? size_t(claims) : 0), "openmany logged %zu claims", batch.logs.size() );
+    for (size_t i = 0; i < owners.size(); ++i) {
+        CHECK( batch.owners[i] == opened.owners[i], "%s has balance %lld, claim day %lld and index day %lld after openmany, "
+               "%lld, %lld and %lld after open", owners[i].to_string().c_str(), (long long)batch.owners[i][0],
+               (long long)batch.owners[i][1], (long long)batch.owners[i][2], (long long)opened.owners[i][0],
+               (long long)opened.owners[i][1], (long long)opened.owners[i][2] );
+    }
+    CHECK( batch.shards == opened.shards, "openmany left other supply shards than open" );
+    CHECK( batch == opened, "openmany logged other claims than open" );
+}
+
+// Whether "account" can claim UBI under "Policy", as the contract checks it.
+template <typename Policy>
+bool eligible( fixture& f, name account ) {
+    return f.c.run_as( contract_account, {}, [&]() { return Policy::check( contract_account, account ); } );
+}
+
+// setelig() keeps the allow and deny lists read by the list policies, and their combinations with
+//   name_suffix behave as the combinators say.
+void eligibility_lists() {
+    using namespace eosio::eligibility;
+    fixture f;
+    f.expect_ok( f.token.setelig( "alice"_n, allowed ), "allow alice" );
+    f.expect_ok( f.token.setelig( "bob.jc"_n, denied ), "deny bob.jc" );
+    f.expect_ok( f.token.setelig( "carol"_n, denied ), "deny carol" );
+    f.expect_ok( f.token.setelig( "carol"_n, unlisted ), "unlist carol" );
+    f.expect_fail( f.token.setelig( "dave"_n, 3 ), "setelig 3", "invalid eligibility status" );
+    f.expect_fail( f.c.push_action( contract_account, "setelig"_n, { {"alice"_n, "active"_n} }, "alice"_n, uint8_t(allowed) ),
+                   "setelig by alice", "missing authority" );
+
+    CHECK( eligible<allowlisted>( f, "alice"_n ) && eligible<not_denylisted>( f, "alice"_n ), "alice is not eligible" );
+    CHECK( !eligible<allowlisted>( f, "bob.jc"_n ) && !eligible<not_denylisted>( f, "bob.jc"_n ), "bob.jc is eligible" );
+    CHECK( !eligible<allowlisted>( f, "carol"_n ) && eligible<not_denylisted>( f, "carol"_n ), "carol is still listed" );
+    CHECK( !eligible<allowlisted>( f, "dave"_n ) && eligible<not_denylisted>( f, "dave"_n ), "dave is listed" );
+
+    // The denylist overrides both the allowlist and the suffix.
+    typedef all_of< not_denylisted, any_of< allowlisted, name_suffix<".jc"_n.value> > > policy;
+    CHECK( eligible<policy>( f, "alice"_n ), "alice is not eligible under all_of" );
+    CHECK( eligible<policy>( f, "erin.jc"_n ), "erin.jc is not eligible under all_of" );
+    CHECK( !eligible<policy>( f, "bob.jc"_n ), "bob.jc is eligible under all_of" );
+    CHECK( !eligible<policy>( f, "dave"_n ), "dave is eligible under all_of" );
+    CHECK( eligible< not_<allowlisted> >( f, "dave"_n ) && !eligible< not_<allowlisted> >( f, "alice"_n ), "not_ of allowlisted" );
+
+    // Unlisting erases the row, so the contract is back to the RAM of the other two.
+    f.expect_ok( f.token.setelig( "alice"_n, unlisted ), "unlist alice" );
+    f.expect_ok( f.token.setelig( "bob.jc"_n, unlisted ), "unlist bob.jc" );
+    const bool listed = f.c.run_as( contract_account, {}, [&]() {
+        listings lst( contract_account, contract_account.value );
+        return lst.begin() != lst.end();
+    });
+    CHECK( !listed, "unlisted accounts are left in the lists" );
+}
+
+// kyc_registry reads the rows of the registry contract, alone and combined with the lists.
+void eligibility_registry() {
+    using namespace eosio::eligibility;
+    typedef kyc_registry< "kycregistry"_n, "verified"_n > registry;
+    fixture f;
+    f.c.run_as( "kycregistry"_n, {}, [&]() {
+        eosio::multi_index< "verified"_n, registry::entry > verified( "kycregistry"_n, "kycregistry"_n.value );
+        for (name account : { "alice"_n, "bob"_n })
+            verified.emplace( "kycregistry"_n, [&]( auto& e ) { e.account = account; } );
+    });
+    f.expect_ok( f.token.setelig( "bob"_n, denied ), "deny bob" );
+
+    CHECK( eligible<registry>( f, "alice"_n ) && eligible<registry>( f, "bob"_n ), "a verified account is not eligible" );
+    CHECK( !eligible<registry>( f, "carol"_n ), "carol is eligible without being verified" );
+    typedef all_of< registry, not_denylisted > policy;
+    CHECK( eligible<policy>( f, "alice"_n ) && !eligible<policy>( f, "bob"_n ), "the denylist does not apply to the registry" );
+}
+
+// A free account creation schedule pays a new row from the day after tomorrow, however long ago the first
+//   claim day was: an account that closes its row and opens it again every day is paid no more than one
+//   that keeps it.
+void reopen_grace() {
+    fixture f;
+    f.expect_ok( f.token.open( "ann"_n, heart, "ann"_n ), "open ann" );
+    f.expect_ok( f.token.open( "ben"_n, heart, "ben"_n ), "open ben" );
+    CHECK( f.token.balance( "ann"_n, heart ).amount == 0, "a new row was paid %lld", (long long)f.token.balance( "ann"_n, heart ).amount );
+    CHECK( f.claim_day( "ann"_n ) == start_day + 1, "a new row starts on day %u", unsigned(f.claim_day( "ann"_n )) );
+
+    // Claim, pay the claim out and close the row, then open it again, every day it lets itself.
+    constexpr uint32_t days = 9;
+    int64_t paid = 0;
+    for (uint32_t d = 0; d < days; ++d) {
+        f.c.advance_days( 1 );
+        if (f.token.close( "ann"_n, heart ))
+            f.expect_ok( f.token.open( "ann"_n, heart, "ann"_n ), "open ann again" );
+        f.expect_ok( f.token.open( "ann"_n, heart, "ann"_n ), "claim" );
+        const int64_t balance = f.token.balance( "ann"_n, heart ).amount;
+        if (balance > 0) {
+            f.expect_ok( f.token.transfer( "ann"_n, "bank"_n, asset{balance, heart}, "" ), "pay out" );
+            paid += balance;
+        }
+    }
+    // ben kept its row, and is paid for every day from the day after tomorrow of its open().
+    f.expect_ok( f.token.open( "ben"_n, heart, "ben"_n ), "claim" );
+    const int64_t kept = f.token.balance( "ben"_n, heart ).amount;
+    CHECK( kept == int64_t(days - 1) * unit, "ben was paid %lld in %u days", (long long)kept, days );
+    CHECK( paid <= kept, "ann was paid %lld in %u days, ben %lld", (long long)paid, days, (long long)kept );
+    f.check_totals( { contract_account, "ann"_n, "ben"_n, "bank"_n } );
+}
+
+struct check_case {
+    const char* name;
+    void (*run)();
+    bool        enabled;    // for the schedule the contract is built with
+};
+
+const check_case checks[] = {
+    { "migrate_legacy_rows",  migrate_legacy_rows,   built_for<ubi_config::heart> },
+    { "migrate_on_transfer",  migrate_on_transfer,   built_for<ubi_config::heart> },
+    { "migrate_on_open",      migrate_on_open,       built_for<ubi_config::heart> },
+    { "close_legacy_row",     close_legacy_row,      built_for<ubi_config::heart> },
+    { "cleanup_pass",         cleanup_pass,          built_for<ubi_config::heart> },
+    { "migrate_pass",         migrate_pass,          built_for<ubi_config::heart> },
+    { "shard_aggregates",     shard_aggregates,      built_for<ubi_config::heart> },
+    { "retire_stat_row",      retire_stat_row,       built_for<ubi_config::heart> },
+    { "missing_shards",       missing_shards,        built_for<ubi_config::heart> },
+    { "metrics_on_close",     metrics_on_close,      built_for<ubi_config::heart> },
+    { "notify_modes",         notify_modes,          built_for<ubi_config::heart> },
+    { "index_row_payer",      index_row_payer,       every_schedule },
+    { "openmany_rows",        openmany_rows,         every_schedule },
+    { "unsorted_owners",      unsorted_owners,       built_for<ubi_config::heart> },
+    { "eligibility_lists",    eligibility_lists,     every_schedule },
+    { "eligibility_registry", eligibility_registry,  every_schedule },
+    { "reopen_grace",         reopen_grace,          built_for<ubi_config::open_chain> },
+};
+
+} /// namespace
+
+int main( int argc, char** argv ) {
+    std::vector<std::string> selected;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp( argv[i], "--verbose" ))
+            verbose = true;
+        else
+            selected.push_back( argv[i] );
+    }
+
+    int failed = 0, ran = 0;
+    for (const auto& check : checks) {
+        if (!check.enabled)
+            continue;
+        if (!selected.empty() && std::find( selected.begin(), selected.end(), check.name ) == selected.end())
+            continue;
+        ++ran;
+        if (verbose)
+            std::printf( "%s\n", check.name );
+        try {
+            check.run();
+        } catch (const check_failure& e) {
+            std::printf( "FAILED %s: %s\n", check.name, e.what() );
+            ++failed;
+        } catch (const native::eosio_assert_exception& e) {
+            std::printf( "FAILED %s: %s\n", check.name, e.what() );
+            ++failed;
+        }
+    }
+    std::printf( "%d checks, %d failed\n", ran, failed );
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,429 @@
+/**
+ * Offline snapshot of the revelation21 tables, and analytics over it.
+ *
+ * "import" reads a JSON table dump (one "{"table": ..., "scope": ..., "rows": [...]}" object per line,
+ *   as written by scripts/dump_tables.sh) of the accounts, extras, stat and supplyshard tables, and
+ *   writes it as a columnar file: a header followed by one array of 64-bit values per column, that
+ *   "report" maps into memory as is. Claim days still held by legacy "extras" rows are merged into the
+ *   balance rows they belong to.
+ *
+ * "report" computes, for every token, the holder distribution, the histogram of claim days, the
+ *   outstanding UBI and the reconciliation of the balances and the UBI aggregates against the stat row
+ *   and the supply shards, splitting the balance rows across threads. It exits with 1 if anything
+ *   does not reconcile.
+ *
+ *   revelation21_snapshot import DUMP.jsonl SNAPSHOT
+ *   revelation21_snapshot report SNAPSHOT [--today DAY] [--threads N]
+ */
+
+#include "json_reader.hpp"
+#include "revelation21.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace eosio;
+namespace json = revelation21::json;
+
+namespace {
+
+typedef ubi_config::UBI_CONFIG config;
+
+// The columns of every table, in file order. Every column is an array of 64-bit values with one value per
+//   row; claim_day is 0 for rows that do not carry a claim day.
+enum account_column { acc_owner, acc_symbol, acc_amount, acc_claim_day, account_columns };
+enum stat_column    { st_symbol, st_supply, st_max_supply, st_issuer, st_ubi_accounts, st_claim_day_sum, stat_columns };
+enum shard_column   { sh_symbol, sh_minted, sh_allowance, sh_ubi_accounts, sh_claim_day_sum, shard_columns };
+
+constexpr char snapshot_magic[8] = { 'R', '2', '1', 'S', 'N', 'A', 'P', '1' };
+
+struct snapshot_header {
+    char     magic[8];
+    uint64_t accounts;
+    uint64_t stats;
+    uint64_t shards;
+};
+
+// Rows of one table, column by column.
+struct table_columns {
+    std::vector<std::vector<uint64_t>> columns;
+
+    explicit table_columns( size_t n ) : columns(n) {}
+
+    size_t rows()const { return columns[0].size(); }
+
+    void add( std::initializer_list<uint64_t> row ) {
+        size_t i = 0;
+        for (uint64_t v : row)
+            columns[i++].push_back( v );
+    }
+};
+
+int import_dump( const char* dump_path, const char* snapshot_path ) {
+    std::ifstream in( dump_path );
+    if (!in) {
+        std::fprintf( stderr, "cannot read %s\n", dump_path );
+        return 1;
+    }
+
+    table_columns accounts( account_columns ), stats( stat_columns ), shards( shard_columns );
+    std::map<std::pair<uint64_t, uint64_t>, uint64_t> legacy_claim_days;   // (owner, symbol code) -> claim day
+    std::string line;
+    uint64_t line_number = 0, skipped = 0;
+    try {
+        while (std::getline( in, line )) {
+            ++line_number;
+            if (line.find_first_not_of( " \t\r" ) == std::string::npos)
+                continue;
+            const json::value dump = json::parse( line );
+            const std::string& table = dump["table"].as_string();
+            const std::string& scope = dump["scope"].as_string();
+            for (const json::value& row : dump["rows"].items) {
+                if (table == "accounts") {
+                    const asset balance = json::to_asset( row["balance"] );
+                    const json::value* claim_day = row.find( "last_claim_day" );
+                    accounts.add( { name( scope ).value, balance.symbol.raw(), uint64_t(balance.amount),
+                                    claim_day ? claim_day->as_uint() : 0 } );
+                } else if (table == "extras") {
+                    legacy_claim_days[ { name( scope ).value, row["symbol_code_raw"].as_uint() } ] = row["last_claim_day"].as_uint();
+                } else if (table == "stat") {
+                    const asset supply = json::to_asset( row["supply"] );
+                    const json::value* ubi_accounts = row.find( "ubi_accounts" );
+                    const json::value* claim_day_sum = row.find( "claim_day_sum" );
+                    stats.add( { supply.symbol.raw(), uint64_t(supply.amount), uint64_t(json::to_asset( row["max_supply"] ).amount),
+                                 json::to_name( row["issuer"] ).value, ubi_accounts ? ubi_accounts->as_uint() : 0,
+                                 claim_day_sum ? claim_day_sum->as_uint() : 0 } );
+                } else if (table == "supplyshard") {
+                    const asset minted = json::to_asset( row["minted"] );
+                    shards.add( { minted.symbol.raw(), uint64_t(minted.amount), uint64_t(json::to_asset( row["allowance"] ).amount),
+                                  uint64_t(row["ubi_accounts"].as_int()), uint64_t(row["claim_day_sum"].as_int()) } );
+                } else {
+                    ++skipped;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf( stderr, "%s:%llu: %s\n", dump_path, (unsigned long long)line_number, e.what() );
+        return 1;
+    }
+
+    // Balance rows written before the "extras" merge carry their claim day in the legacy table.
+    uint64_t merged = 0;
+    for (size_t i = 0; i < accounts.rows(); ++i) {
+        if (accounts.columns[acc_claim_day][i])
+            continue;
+        auto it = legacy_claim_days.find( { accounts.columns[acc_owner][i], symbol( accounts.columns[acc_symbol][i] ).code().raw() } );
+        if (it != legacy_claim_days.end()) {
+            accounts.columns[acc_claim_day][i] = it->second;
+            ++merged;
+        }
+    }
+
+    std::ofstream out( snapshot_path, std::ios::binary | std::ios::trunc );
+    snapshot_header header;
+    std::memcpy( header.magic, snapshot_magic, sizeof(snapshot_magic) );
+    header.accounts = accounts.rows();
+    header.stats = stats.rows();
+    header.shards = shards.rows();
+    out.write( reinterpret_cast<const char*>( &header ), sizeof(header) );
+    for (const table_columns* t : { &accounts, &stats, &shards })
+        for (const auto& column : t->columns)
+            out.write( reinterpret_cast<const char*>( column.data() ), column.size() * sizeof(uint64_t) );
+    if (!out) {
+        std::fprintf( stderr, "cannot write %s\n", snapshot_path );
+        return 1;
+    }
+
+    std::printf( "%llu balance rows (%llu with a legacy claim day), %llu stat rows, %llu supply shards",
+                 (unsigned long long)header.accounts, (unsigned long long)merged,
+                 (unsigned long long)header.stats, (unsigned long long)header.shards );
+    if (skipped)
+        std::printf( ", %llu rows of other tables skipped", (unsigned long long)skipped );
+    std::printf( "\n" );
+    return 0;
+}
+
+// A snapshot file mapped into memory.
+class snapshot {
+    public:
+        explicit snapshot( const char* path ) {
+            const int fd = open( path, O_RDONLY );
+            struct stat st;
+            if (fd < 0 || fstat( fd, &st ) != 0 || size_t(st.st_size) < sizeof(snapshot_header)) {
+                if (fd >= 0)
+                    close( fd );
+                throw std::runtime_error( std::string( "cannot read " ) + path );
+            }
+            _size = st.st_size;
+            _data = mmap( nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            close( fd );
+            if (_data == MAP_FAILED)
+                throw std::runtime_error( std::string( "cannot map " ) + path );
+
+            const auto* h = header();
+            const uint64_t values = h->accounts * account_columns + h->stats * stat_columns + h->shards * shard_columns;
+            if (std::memcmp( h->magic, snapshot_magic, sizeof(snapshot_magic) ) != 0 || _size != sizeof(snapshot_header) + values * sizeof(uint64_t))
+                throw std::runtime_error( std::string( path ) + " is not a revelation21 snapshot" );
+        }
+
+        ~snapshot() {
+            munmap( _data, _size );
+        }
+
+        const snapshot_header* header()const { return static_cast<const snapshot_header*>( _data ); }
+
+        const uint64_t* account( account_column c )const { return column( 0, header()->accounts, c ); }
+        const uint64_t* stat( stat_column c )const { return column( header()->accounts * account_columns, header()->stats, c ); }
+        const uint64_t* shard( shard_column c )const {
+            return column( header()->accounts * account_columns + header()->stats * stat_columns, header()->shards, c );
+        }
+
+    private:
+        const uint64_t* column( uint64_t table_offset, uint64_t rows, uint64_t c )const {
+            return reinterpret_cast<const uint64_t*>( header() + 1 ) + table_offset + rows * c;
+        }
+
+        void*  _data = nullptr;
+        size_t _size = 0;
+};
+
+constexpr const char* size_buckets[] = { "0", "< 1", "1 - 9", "10 - 99", "100 - 999", "1k - 9999", "10k - 99999", ">= 100k" };
+constexpr size_t size_bucket_count = sizeof(size_buckets) / sizeof(size_buckets[0]);
+
+constexpr const char* lag_buckets[] = { "up to date", "1 day", "2 - 7 days", "8 - 30 days", "31 - 365 days", "> 365 days" };
+constexpr size_t lag_bucket_count = sizeof(lag_buckets) / sizeof(lag_buckets[0]);
+
+constexpr size_t top_holders = 10;
+
+// What the balance rows of one token add up to, over the rows a worker was given.
+struct token_tally {
+    uint64_t  holders = 0;
+    int64_t   balance_sum = 0;
+    uint64_t  ubi_accounts = 0;
+    uint64_t  claim_day_sum = 0;
+    int64_t   unclaimed_days = 0;   // as get_ubi_liability() counts them: uncapped, today's pay included
+    int64_t   claimable_days = 0;   // what claims made today would pay, capped to max_past_claim_days
+    int64_t   lost_days = 0;
+    std::array<uint64_t, size_bucket_count>  holders_by_size{};
+    std::array<int64_t, size_bucket_count>   balance_by_size{};
+    std::array<uint64_t, lag_bucket_count>   accounts_by_lag{};
+    std::vector<std::pair<int64_t, uint64_t>> top;   // (balance, owner), largest first
+
+    void add_top( int64_t amount, uint64_t owner ) {
+        if (top.size() == top_holders && amount <= top.back().first)
+            return;
+        top.insert( std::upper_bound( top.begin(), top.end(), std::make_pair( amount, owner ),
+                                      []( const auto& a, const auto& b ) { return a.first > b.first; } ),
+                    std::make_pair( amount, owner ) );
+        if (top.size() > top_holders)
+            top.pop_back();
+    }
+
+    void merge( const token_tally& o ) {
+        holders += o.holders;
+        balance_sum += o.balance_sum;
+        ubi_accounts += o.ubi_accounts;
+        claim_day_sum += o.claim_day_sum;
+        unclaimed_days += o.unclaimed_days;
+        claimable_days += o.claimable_days;
+        lost_days += o.lost_days;
+        for (size_t i = 0; i < size_bucket_count; ++i) {
+            holders_by_size[i] += o.holders_by_size[i];
+            balance_by_size[i] += o.balance_by_size[i];
+        }
+        for (size_t i = 0; i < lag_bucket_count; ++i)
+            accounts_by_lag[i] += o.accounts_by_lag[i];
+        for (const auto& t : o.top)
+            add_top( t.first, t.second );
+    }
+};
+
+size_t size_bucket( int64_t amount, int64_t precision_multiplier ) {
+    if (amount <= 0)
+        return 0;
+    size_t bucket = 1;
+    for (int64_t whole = amount / precision_multiplier, limit = 1; whole >= limit && bucket < size_bucket_count - 1; limit *= 10)
+        ++bucket;
+    return bucket;
+}
+
+size_t lag_bucket( int64_t lag ) {
+    return lag <= 0 ? 0 : lag == 1 ? 1 : lag <= 7 ? 2 : lag <= 30 ? 3 : lag <= 365 ? 4 : 5;
+}
+
+std::map<uint64_t, token_tally> tally_rows( const snapshot& snap, size_t begin, size_t end, int64_t today ) {
+    const uint64_t* owner = snap.account( acc_owner );
+    const uint64_t* sym = snap.account( acc_symbol );
+    const uint64_t* amount = snap.account( acc_amount );
+    const uint64_t* claim_day = snap.account( acc_claim_day );
+
+    std::map<uint64_t, token_tally> tallies;
+    uint64_t last_symbol = 0;
+    token_tally* t = nullptr;
+    for (size_t i = begin; i < end; ++i) {
+        if (!t || sym[i] != last_symbol) {
+            last_symbol = sym[i];
+            t = &tallies[last_symbol];
+        }
+        const symbol s( sym[i] );
+        const int64_t multiplier = ubi_config::precision_multipliers[ std::min<uint8_t>( s.precision(), ubi_config::max_precision ) ];
+        const int64_t balance = int64_t(amount[i]);
+
+        ++t->holders;
+        t->balance_sum += balance;
+        const size_t bucket = size_bucket( balance, multiplier );
+        ++t->holders_by_size[bucket];
+        t->balance_by_size[bucket] += balance;
+        t->add_top( balance, owner[i] );
+
+        if (!claim_day[i])
+            continue;
+        ++t->ubi_accounts;
+        t->claim_day_sum += claim_day[i];
+        t->unclaimed_days += today - 1 + config::claim_days - int64_t(claim_day[i]);
+        const auto claim = token::compute_claim( token::time_type(claim_day[i]), token::time_type(today), s, INT64_MAX );
+        t->claimable_days += claim.quantity.amount / multiplier;
+        t->lost_days += claim.lost_days;
+        ++t->accounts_by_lag[ lag_bucket( today - int64_t(claim_day[i]) ) ];
+    }
+    return tallies;
+}
+
+std::string amount_string( int64_t amount, const symbol& s ) {
+    return asset{ amount, s }.to_string();
+}
+
+int report( const char* snapshot_path, int64_t today, uint32_t threads ) {
+    const snapshot snap( snapshot_path );
+    const uint64_t rows = snap.header()->accounts;
+
+    // Every worker tallies a contiguous range of the balance rows; the ranges are merged once all are done.
+    threads = std::max<uint32_t>( 1, std::min<uint64_t>( threads, rows / 4096 + 1 ) );
+    std::vector<std::map<uint64_t, token_tally>> partial( threads );
+    std::vector<std::thread> workers;
+    for (uint32_t w = 0; w < threads; ++w)
+        workers.emplace_back( [&, w]() { partial[w] = tally_rows( snap, rows * w / threads, rows * (w + 1) / threads, today ); } );
+    for (auto& worker : workers)
+        worker.join();
+    std::map<uint64_t, token_tally> tallies;
+    for (const auto& p : partial)
+        for (const auto& t : p)
+            tallies[t.first].merge( t.second );
+
+    std::printf( "%llu balance rows, %u threads, day %lld\n", (unsigned long long)rows, threads, (long long)today );
+
+    bool reconciled = true;
+    for (uint64_t i = 0; i < snap.header()->stats; ++i) {
+        const symbol s( snap.stat( st_symbol )[i] );
+        const int64_t multiplier = ubi_config::precision_multipliers[ std::min<uint8_t>( s.precision(), ubi_config::max_precision ) ];
+        const token_tally& t = tallies[s.raw()];
+
+        int64_t supply = int64_t(snap.stat( st_supply )[i]);
+        int64_t allowance = 0;
+        int64_t ubi_accounts = int64_t(snap.stat( st_ubi_accounts )[i]);
+        int64_t claim_day_sum = int64_t(snap.stat( st_claim_day_sum )[i]);
+        for (uint64_t j = 0; j < snap.header()->shards; ++j) {
+            if (snap.shard( sh_symbol )[j] != s.raw())
+                continue;
+            supply += int64_t(snap.shard( sh_minted )[j]);
+            allowance += int64_t(snap.shard( sh_allowance )[j]);
+            ubi_accounts += int64_t(snap.shard( sh_ubi_accounts )[j]);
+            claim_day_sum += int64_t(snap.shard( sh_claim_day_sum )[j]);
+        }
+        const int64_t max_supply = int64_t(snap.stat( st_max_supply )[i]);
+
+        std::printf( "\n%s, issued by %s\n", s.code().to_string().c_str(), name( snap.stat( st_issuer )[i] ).to_string().c_str() );
+        std::printf( "  holders %llu, UBI accounts %llu\n", (unsigned long long)t.holders, (unsigned long long)t.ubi_accounts );
+
+        std::printf( "  holder distribution (whole tokens):\n" );
+        for (size_t b = 0; b < size_bucket_count; ++b)
+            std::printf( "    %-12s %10llu holders %26s\n", size_buckets[b], (unsigned long long)t.holders_by_size[b],
+                         amount_string( t.balance_by_size[b], s ).c_str() );
+        std::printf( "  top holders:\n" );
+        for (const auto& top : t.top)
+            std::printf( "    %-12s %26s\n", name( top.second ).to_string().c_str(), amount_string( top.first, s ).c_str() );
+
+        std::printf( "  claim days behind today:\n" );
+        for (size_t b = 0; b < lag_bucket_count; ++b)
+            std::printf( "    %-14s %10llu accounts\n", lag_buckets[b], (unsigned long long)t.accounts_by_lag[b] );
+
+        std::printf( "  outstanding UBI: %s claimable today (%lld days), %lld days lost past the %lld day limit\n",
+                     amount_string( t.claimable_days * multiplier, s ).c_str(), (long long)t.claimable_days,
+                     (long long)t.lost_days, (long long)config::max_past_claim_days );
+
+        auto check = [&]( const char* what, int64_t scanned, int64_t recorded, bool is_amount ) {
+            const bool ok = scanned == recorded;
+            reconciled = reconciled && ok;
+            if (is_amount)
+                std::printf( "    %-16s %26s %26s  %s\n", what, amount_string( scanned, s ).c_str(), amount_string( recorded, s ).c_str(), ok ? "ok" : "MISMATCH" );
+            else
+                std::printf( "    %-16s %26lld %26lld  %s\n", what, (long long)scanned, (long long)recorded, ok ? "ok" : "MISMATCH" );
+        };
+        std::printf( "  reconciliation:  %26s %26s\n", "balance rows", "stat row and shards" );
+        check( "supply", t.balance_sum, supply, true );
+        check( "UBI accounts", t.ubi_accounts, ubi_accounts, false );
+        check( "claim day sum", t.claim_day_sum, claim_day_sum, false );
+        check( "unclaimed days", t.unclaimed_days, ubi_accounts * (today - 1 + config::claim_days) - claim_day_sum, false );
+        const bool capped = supply + allowance <= max_supply;
+        reconciled = reconciled && capped;
+        std::printf( "  supply plus shard allowances %s of max supply %s  %s\n", amount_string( supply + allowance, s ).c_str(),
+                     amount_string( max_supply, s ).c_str(), capped ? "ok" : "OVER" );
+    }
+
+    for (const auto& t : tallies) {
+        bool listed = false;
+        for (uint64_t i = 0; i < snap.header()->stats; ++i)
+            listed = listed || snap.stat( st_symbol )[i] == t.first;
+        if (!listed) {
+            std::printf( "\n%s: %llu balance rows without a stat row\n", symbol( t.first ).code().to_string().c_str(),
+                         (unsigned long long)t.second.holders );
+            reconciled = false;
+        }
+    }
+    return reconciled ? 0 : 1;
+}
+
+} /// namespace
+
+int main( int argc, char** argv ) {
+    if (argc == 4 && !std::strcmp( argv[1], "import" ))
+        return import_dump( argv[2], argv[3] );
+
+    if (argc >= 3 && !std::strcmp( argv[1], "report" )) {
+        int64_t today = std::time( nullptr ) / 86400;
+        uint32_t threads = std::max( 1u, std::thread::hardware_concurrency() );
+        for (int i = 3; i + 1 < argc; i += 2) {
+            if (!std::strcmp( argv[i], "--today" ))
+                today = std::strtoll( argv[i + 1], nullptr, 10 );
+            else if (!std::strcmp( argv[i], "--threads" ))
+                threads = std::strtoul( argv[i + 1], nullptr, 10 );
+            else {
+                std::fprintf( stderr, "unknown option %s\n", argv[i] );
+                return 1;
+            }
+        }
+        try {
+            return report( argv[2], today, threads );
+        } catch (const std::exception& e) {
+            std::fprintf( stderr, "%s\n", e.what() );
+            return 1;
+        }
+    }
+
+    std::fprintf( stderr, "usage: %s import DUMP.jsonl SNAPSHOT\n"
+                          "       %s report SNAPSHOT [--today DAY] [--threads N]\n", argv[0], argv[0] );
+    return 1;
+}
@@ -0,0 +1,748 @@
+/**
+ * Differential fuzzing of the revelation21 contract against a reference model.
+ *
+ * Every input is decoded into a token with a random precision, max_supply and start day, followed by
+ *   a random sequence of open, close, transfer, transfermany, issue, retire, compact and setelig actions
+ *   and of clock moves, from a few hours up to tens of thousands of days. Each action is pushed to the
+ *   native chain and applied to a plain model of eosio.token with the UBI schedule of ubi_config.hpp
+ *   the contract is built with (see UBI_CONFIG), written with 64-bit day counts and without the
+ *   contract's tables. After every action the harness checks:
+ *
+ *   - that the action failed on chain if and only if the model rejected it;
+ *   - the balance of every account, the supply and the claim days of the "claimindex" table against
+ *     the model;
+ *   - conservation: the balances add up to the supply, and the supply of the stat row alone never goes
+ *     below zero;
+ *   - the cap: the supply, plus what the supply shards are still allowed to mint, stays within
+ *     max_supply;
+ *   - no double claims: no claim day is past the days paid in advance, and no account has been paid
+ *     more than the days its claim day has moved over;
+ *   - with the grace period of free account creation, no account has been paid, over all the rows it
+ *     opened, for the days before it opened the first one.
+ *
+ * Built with -DREVELATION21_LIBFUZZER, this file is a libFuzzer target (LLVMFuzzerTestOneInput).
+ *   Otherwise it is a property driver that runs random inputs, built once per schedule
+ *   (revelation21_props for HEART, revelation21_props_kyc_monthly, ...):
+ *
+ *   revelation21_props [--sequences N] [--length N] [--seed N] [--jobs N] [--replay HEX] [--verbose]
+ *
+ * A failing input is printed as hex. "--replay HEX --verbose" runs it again and prints every step.
+ */
+
+#include "token_driver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef REVELATION21_LIBFUZZER
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace eosio;
+using revelation21::token_driver;
+using native::push_result;
+
+namespace {
+
+// The schedule the contract is built with. The model takes its numbers from it, and has its own
+//   version of its eligibility policy below.
+typedef ubi_config::UBI_CONFIG schedule;
+
+// The eligibility policies of the schedules, as the model sees them: from the name of the account and
+//   the status setelig() gave it. A schedule with another policy needs its own specialization here.
+template <typename Policy>
+struct policy_model;
+
+template <uint64_t Suffix>
+struct policy_model< eligibility::name_suffix<Suffix> > {
+    static bool eligible( name account, uint8_t ) {
+        const std::string s = account.to_string();
+        const std::string suffix = name( Suffix ).to_string();
+        return s.size() > suffix.size() && s.compare( s.size() - suffix.size(), suffix.size(), suffix ) == 0;
+    }
+};
+
+template <>
+struct policy_model< eligibility::allowlisted > {
+    static bool eligible( name, uint8_t status ) { return status == eligibility::allowed; }
+};
+
+template <>
+struct policy_model< eligibility::not_denylisted > {
+    static bool eligible( name, uint8_t status ) { return status != eligibility::denied; }
+};
+
+constexpr int64_t first_claim_day = schedule::first_claim_day + (schedule::unbounded_UBI_account_creation ? 2 : 0);
+constexpr bool grace_period = schedule::unbounded_UBI_account_creation;
+constexpr uint32_t shard_count = schedule::supply_shard_count;
+
+// Days past this one would not fit the contract's 16-bit day counts.
+constexpr uint32_t last_day = 65000;
+
+const name contract_account = "revelation21"_n;
+
+// The accounts the sequences play with: accounts that can claim by name, accounts that cannot, and the
+//   issuer. setelig() moves any of them on and off the lists.
+const name pool[] = { "alice.jc"_n, "bob.jc"_n, "carol.jc"_n, "frank.jc"_n, "dave"_n, "erin"_n, contract_account };
+constexpr size_t pool_size = sizeof(pool) / sizeof(pool[0]);
+
+struct property_failure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+#define CHECK( cond, ... ) \
+    do { if (!(cond)) fail( __VA_ARGS__ ); } while (0)
+
+template <typename... Args>
+[[noreturn]] void fail( const char* format, Args... args ) {
+    char buf[512];
+    std::snprintf( buf, sizeof(buf), format, args... );
+    throw property_failure( buf );
+}
+
+// The input bytes, read one at a time; zeros once they run out.
+class input_reader {
+    public:
+        input_reader( const uint8_t* data, size_t size ) : _p(data), _end(data + size) {}
+
+        bool done()const { return _p >= _end; }
+
+        uint8_t byte() { return _p < _end ? *_p++ : 0; }
+
+        uint32_t word() { return uint32_t( byte() ) << 8 | byte(); }
+
+    private:
+        const uint8_t* _p;
+        const uint8_t* _end;
+};
+
+// eosio.token with UBI, as the contract documents it.
+struct model {
+    struct row {
+        int64_t balance = 0;
+        bool    ubi = false;
+        int64_t claim_day = 0;     // income is paid up to this day
+        int64_t opened_day = 0;    // claim day the row was opened with, or started claiming on
+        int64_t claimed = 0;       // paid by claims since the row was opened
+        int64_t lost_days = 0;     // days of income lost since the row was opened
+    };
+
+    int64_t                  max_supply = 0;
+    int64_t                  unit = 1;
+    int64_t                  supply = 0;            // stat row
+    int64_t                  minted[shard_count] = {};
+    int64_t                  allowance[shard_count] = {};
+    std::map<uint64_t, row>  rows;
+    std::map<uint64_t, int64_t> first_opened;       // day each account first opened a row, for the grace period
+    std::map<uint64_t, int64_t> paid;               // paid to each account by claims, over all of its rows
+    std::map<uint64_t, uint8_t> listed;             // setelig() statuses, other than unlisted
+    int64_t                  today = 0;
+
+    bool eligible( name account )const {
+        auto it = listed.find( account.value );
+        return policy_model<schedule::eligibility_policy>::eligible( account, it != listed.end() ? it->second : eligibility::unlisted );
+    }
+
+    static uint32_t shard_of( name owner ) {
+        uint64_t x = owner.value;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return uint32_t( (x ^ (x >> 31)) % shard_count );
+    }
+
+    int64_t total_supply()const {
+        int64_t total = supply;
+        for (int64_t m : minted)
+            total += m;
+        return total;
+    }
+
+    void renew_shards() {
+        const int64_t headroom = max_supply - total_supply();
+        supply = total_supply();
+        for (uint32_t id = 0; id < shard_count; ++id) {
+            minted[id] = 0;
+            allowance[id] = headroom / shard_count + (id == 0 ? headroom % shard_count : 0);
+        }
+    }
+
+    row& open_row( name owner ) {
+        row& r = rows[owner.value];
+        r = row();
+        r.ubi = eligible( owner );
+        r.claim_day = r.opened_day = new_claim_day();
+        first_opened.emplace( owner.value, today );
+        return r;
+    }
+
+    // With the grace period, a row is paid from the day after the day after it is opened (or starts
+    //   claiming), and never for the days before.
+    int64_t new_claim_day()const {
+        return grace_period ? std::max( first_claim_day, today + 1 ) : first_claim_day;
+    }
+
+    // The days of income a claim made today pays to "owner", and the days it loses. Whether it can claim
+    //   is checked on every claim, so a row keeps its claim day while its owner is not eligible, and a
+    //   row opened before its owner was eligible claims from the first claim day.
+    int64_t claimable_days( name owner, const row& r, int64_t& lost )const {
+        lost = 0;
+        if (owner == contract_account || !eligible( owner ))
+            return 0;
+        const int64_t claim_day = r.ubi ? r.claim_day : new_claim_day();
+        if (claim_day >= today)
+            return 0;
+        int64_t days = today - claim_day - 1;
+        if (days > schedule::max_past_claim_days) {
+            lost = days - schedule::max_past_claim_days;
+            days = schedule::max_past_claim_days;
+        }
+        days += schedule::claim_days;
+
+        // What is left of the shard allowance pays for as many whole days as it can.
+        return std::max<int64_t>( 0, std::min( days, allowance[shard_of( owner )] / unit ) );
+    }
+
+    void claim( name owner, row& r ) {
+        int64_t lost = 0;
+        const int64_t days = claimable_days( owner, r, lost );
+        if (!r.ubi && owner != contract_account && eligible( owner )) {
+            r.ubi = true;
+            r.claim_day = r.opened_day = new_claim_day();
+        }
+        if (days == 0)
+            return;
+        paid[owner.value] += days * unit;
+        allowance[shard_of( owner )] -= days * unit;
+        minted[shard_of( owner )] += days * unit;
+        r.balance += days * unit;
+        r.claimed += days * unit;
+        r.lost_days += lost;
+        r.claim_day += lost + days;
+    }
+
+    void credit( name owner, int64_t amount ) {
+        auto it = rows.find( owner.value );
+        if (it == rows.end())
+            open_row( owner ).balance = amount;
+        else
+            it->second.balance += amount;
+    }
+
+    // The actions: each returns false, leaving the model in an unspecified state, if the contract
+    //   must reject it.
+    bool open( name owner ) {
+        auto it = rows.find( owner.value );
+        row& r = it != rows.end() ? it->second : open_row( owner );
+        claim( owner, r );
+        return true;
+    }
+
+    bool close( name owner ) {
+        auto it = rows.find( owner.value );
+        if (it == rows.end() || it->second.balance != 0)
+            return false;
+        if (it->second.ubi && it->second.claim_day >= today)
+            return false;
+        rows.erase( it );
+        return true;
+    }
+
+    bool transfer( name from, name to, int64_t amount ) {
+        if (amount <= 0)
+            return false;
+        if (from == to)
+            return true;
+        return pay( from, { std::make_pair( to, amount ) } );
+    }
+
+    bool transfermany( name from, const std::vector<std::pair<name, int64_t>>& payments ) {
+        for (const auto& p : payments) {
+            if (p.second <= 0)
+                return false;
+        }
+        std::vector<std::pair<name, int64_t>> others;
+        for (const auto& p : payments) {
+            if (p.first != from)
+                others.push_back( p );
+        }
+        return others.empty() || pay( from, others );
+    }
+
+    bool pay( name from, const std::vector<std::pair<name, int64_t>>& payments ) {
+        auto it = rows.find( from.value );
+        if (it == rows.end())
+            return false;
+        claim( from, it->second );
+        int64_t total = 0;
+        for (const auto& p : payments)
+            total += p.second;
+        if (it->second.balance < total)
+            return false;
+        it->second.balance -= total;
+        for (const auto& p : payments)
+            credit( p.first, p.second );
+        return true;
+    }
+
+    bool issue( name to, int64_t amount ) {
+        if (amount <= 0)
+            return false;
+        // Only what is neither minted nor allowed to a shard can be issued, taking back shard
+        //   allowances in shard order if needed.
+        int64_t available = max_supply - total_supply();
+        for (int64_t a : allowance)
+            available -= a;
+        for (uint32_t id = 0; id < shard_count && available < amount; ++id) {
+            const int64_t taken = std::min( amount - available, allowance[id] );
+            if (taken > 0) {
+                allowance[id] -= taken;
+                available += taken;
+            }
+        }
+        if (amount > available)
+            return false;
+        supply += amount;
+        credit( contract_account, amount );
+        return to == contract_account || pay( contract_account, { std::make_pair( to, amount ) } );
+    }
+
+    bool retire( int64_t amount ) {
+        if (amount <= 0)
+            return false;
+        auto it = rows.find( contract_account.value );
+        if (it == rows.end() || it->second.balance < amount)
+            return false;
+        for (int64_t& m : minted) {
+            supply += m;
+            m = 0;
+        }
+        supply -= amount;
+        it->second.balance -= amount;
+        return true;
+    }
+
+    bool compact() {
+        renew_shards();
+        return true;
+    }
+
+    bool setelig( name account, uint8_t status ) {
+        if (status > eligibility::denied)
+            return false;
+        if (status == eligibility::unlisted)
+            return listed.erase( account.value ) == 1;
+        listed[account.value] = status;
+        return true;
+    }
+};
+
+// Runs one input against the contract and the model.
+class sequence_runner {
+    public:
+        explicit sequence_runner( bool verbose ) : _verbose(verbose) {}
+
+        uint64_t actions = 0;
+        uint64_t rejected = 0;
+
+        // The first property the input breaks, or the empty string.
+        std::string run( const uint8_t* data, size_t size ) {
+            try {
+                run_sequence( input_reader( data, size ) );
+            } catch (const property_failure& e) {
+                return e.what();
+            }
+            return std::string();
+        }
+
+    private:
+        void run_sequence( input_reader in ) {
+            native::chain& c = native::chain::instance();
+            c.reset();
+            token_driver token( c, contract_account );
+
+            static const uint8_t precisions[] = { 0, 2, 4 };
+            const uint8_t precision = precisions[in.byte() % 3];
+            _sym = symbol( "HEART", precision );
+            _model = model();
+            _model.unit = ubi_config::precision_multipliers[precision];
+            // A small max_supply runs the shards out of allowance within a few claims.
+            const uint8_t cap = in.byte();
+            _model.max_supply = (cap < 128 ? 16 + cap * 3 : 2100000000ll) * _model.unit + cap % 7;
+            _model.today = first_claim_day - 4 + in.byte() % 40;
+            c.set_day( uint32_t( _model.today ) );
+
+            CHECK( token.create( contract_account, asset{_model.max_supply, _sym} ), "create failed" );
+            _model.renew_shards();
+            log( "create %lld, precision %u, day %lld", (long long)_model.max_supply, unsigned(precision), (long long)_model.today );
+            check( token );
+
+            // Most actions need a balance row: open some of them right away.
+            const uint8_t opened = in.byte();
+            for (size_t i = 0; i < pool_size; ++i) {
+                if (opened & (1 << i))
+                    open( token, pool[i] );
+            }
+
+            while (!in.done()) {
+                model next = _model;
+                push_result result;
+                const uint8_t op = in.byte() % 13;
+                const name a = pool[in.byte() % pool_size];
+                switch (op) {
+                    case 0:
+                    case 1: {
+                        open( token, a );
+                        continue;
+                    }
+                    case 2: {
+                        const bool expected = next.close( a );
+                        result = token.close( a, _sym );
+                        expect( result, expected, "close %s", a.to_string().c_str() );
+                        break;
+                    }
+                    case 3:
+                    case 4:
+                    case 5: {
+                        const name b = pool[in.byte() % pool_size];
+                        const int64_t amount = read_amount( in );
+                        const bool expected = next.transfer( a, b, amount );
+                        result = token.transfer( a, b, asset{amount, _sym}, "" );
+                        expect( result, expected, "transfer %s -> %s %lld", a.to_string().c_str(), b.to_string().c_str(), (long long)amount );
+                        break;
+                    }
+                    case 6: {
+                        std::vector<std::pair<name, int64_t>> payments( 1 + in.byte() % 3 );
+                        std::vector<eosio::token::payment> args;
+                        for (auto& p : payments) {
+                            p = std::make_pair( pool[in.byte() % pool_size], read_amount( in ) );
+                            args.push_back( eosio::token::payment{ p.first, asset{p.second, _sym}, "" } );
+                        }
+                        const bool expected = next.transfermany( a, payments );
+                        result = token.transfermany( a, args );
+                        expect( result, expected, "transfermany %s, %zu payments", a.to_string().c_str(), payments.size() );
+                        break;
+                    }
+                    case 7: {
+                        const int64_t amount = read_amount( in );
+                        const bool expected = next.issue( a, amount );
+                        result = token.issue( a, asset{amount, _sym}, "" );
+                        expect( result, expected, "issue %s %lld", a.to_string().c_str(), (long long)amount );
+                        break;
+                    }
+                    case 8: {
+                        const int64_t amount = read_amount( in );
+                        const bool expected = next.retire( amount );
+                        result = token.retire( contract_account, asset{amount, _sym}, "" );
+                        expect( result, expected, "retire %lld", (long long)amount );
+                        break;
+                    }
+                    case 9: {
+                        const bool expected = next.compact();
+                        result = token.compact( _sym.code() );
+                        expect( result, expected, "compact" );
+                        break;
+                    }
+                    case 10: {
+                        const uint8_t status = in.byte() % 4;
+                        const bool expected = next.setelig( a, status );
+                        result = token.setelig( a, status );
+                        expect( result, expected, "setelig %s %u", a.to_string().c_str(), unsigned(status) );
+                        break;
+                    }
+                    case 11: {
+                        // Up to three days, to a random hour, so that some actions share a day.
+                        const uint32_t days = in.byte() % 4;
+                        const uint32_t hour = in.byte() % 24;
+                        if (c.day() + days > last_day)
+                            continue;
+                        c.set_time( (c.day() + days) * native::microseconds_per_day + hour * 3600000000ull );
+                        _model.today = c.day();
+                        log( "day %lld, hour %u", (long long)_model.today, hour );
+                        continue;
+                    }
+                    default: {
+                        // Up to a hundred years, past the days of income an account can accumulate.
+                        const uint32_t days = 1 + in.word() % 40000;
+                        if (c.day() + days > last_day)
+                            continue;
+                        c.advance_days( days );
+                        _model.today = c.day();
+                        log( "day %lld", (long long)_model.today );
+                        continue;
+                    }
+                }
+                applied( token, result, next );
+            }
+        }
+
+        void open( token_driver& token, name a ) {
+            model next = _model;
+            const bool expected = next.open( a );
+            const push_result result = token.open( a, _sym, a );
+            expect( result, expected, "open %s", a.to_string().c_str() );
+            applied( token, result, next );
+        }
+
+        // Takes the model "next" computed for an action the chain accepted, and checks the state.
+        void applied( token_driver& token, const push_result& result, model& next ) {
+            ++actions;
+            if (result)
+                _model = std::move( next );
+            else
+                ++rejected;
+            check( token );
+        }
+
+        // Mostly valid amounts of all sizes, and a few zero ones.
+        int64_t read_amount( input_reader& in ) {
+            const uint8_t kind = in.byte();
+            const int64_t x = in.byte();
+            switch (kind % 8) {
+                case 0:  return x % 2;
+                case 1:
+                case 2:
+                case 3:
+                case 4:  return x * _model.unit / 16 + 1;
+                case 5:
+                case 6:  return x * _model.unit;
+                default: return x * _model.unit * 64;
+            }
+        }
+
+        template <typename... Args>
+        void expect( const push_result& result, bool expected, const char* format, Args... args ) {
+            char what[256];
+            std::snprintf( what, sizeof(what), format, args... );
+            log( "%s: %s", what, result ? "ok" : result.error.c_str() );
+            if (bool(result) != expected)
+                fail( "%s: %s on chain, but the model %s it (day %lld)", what, result ? "succeeded" : result.error.c_str(),
+                      expected ? "accepts" : "rejects", (long long)_model.today );
+        }
+
+        void check( token_driver& token ) {
+            const int64_t supply = token.supply( _sym ).amount;
+            CHECK( supply == _model.total_supply(), "supply is %lld, the model has %lld", (long long)supply, (long long)_model.total_supply() );
+            CHECK( supply <= _model.max_supply, "supply %lld is over max_supply", (long long)supply );
+            const int64_t stat_supply = token.stat_supply( _sym ).amount;
+            CHECK( stat_supply == _model.supply && stat_supply >= 0, "the stat row supply is %lld, the model has %lld",
+                   (long long)stat_supply, (long long)_model.supply );
+
+            int64_t allowed = 0;
+            for (int64_t a : _model.allowance)
+                allowed += a;
+            CHECK( supply + allowed <= _model.max_supply, "supply %lld and shard allowances %lld are over max_supply",
+                   (long long)supply, (long long)allowed );
+
+            int64_t sum = 0;
+            uint64_t ubi_rows = 0;
+            for (name account : pool) {
+                auto it = _model.rows.find( account.value );
+                const int64_t expected = it != _model.rows.end() ? it->second.balance : 0;
+                // What a claim would pay right now as well, which reads the same rows a claim does but
+                //   does not throw for accounts without a balance row.
+                int64_t lost = 0;
+                const int64_t expected_claim = it != _model.rows.end() ? _model.claimable_days( account, it->second, lost ) * _model.unit : 0;
+                const auto accrued = token.accrued( account, _sym );
+                const int64_t balance = accrued.balance.amount - accrued.claimable.amount;
+                CHECK( balance == expected, "balance of %s is %lld, the model has %lld", account.to_string().c_str(),
+                       (long long)balance, (long long)expected );
+                CHECK( accrued.claimable.amount == expected_claim, "%s can claim %lld, the model says %lld", account.to_string().c_str(),
+                       (long long)accrued.claimable.amount, (long long)expected_claim );
+                CHECK( accrued.lost_days == lost, "%s would lose %u days, the model says %lld", account.to_string().c_str(),
+                       unsigned(accrued.lost_days), (long long)lost );
+                sum += balance;
+                // With the grace period, an account is never paid for the days before it first opened a row,
+                //   however many times it closes its row and opens it again.
+                auto paid = _model.paid.find( account.value );
+                if (grace_period && paid != _model.paid.end()) {
+                    const int64_t days = _model.today - _model.first_opened.at( account.value ) - 1 + schedule::claim_days;
+                    CHECK( paid->second <= std::max<int64_t>( 0, days ) * _model.unit, "%s was paid %lld in %lld days",
+                           account.to_string().c_str(), (long long)paid->second, (long long)days );
+                }
+                if (it == _model.rows.end() || !it->second.ubi)
+                    continue;
+
+                const model::row& r = it->second;
+                ++ubi_rows;
+                // Rows opened before the first claim day start on it.
+                CHECK( r.claim_day <= std::max( _model.today - 1 + schedule::claim_days, r.opened_day ), "%s has claimed up to day %lld on day %lld",
+                       account.to_string().c_str(), (long long)r.claim_day, (long long)_model.today );
+                CHECK( r.claimed <= (r.claim_day - r.opened_day - r.lost_days) * _model.unit,
+                       "%s was paid %lld for %lld days", account.to_string().c_str(), (long long)r.claimed,
+                       (long long)(r.claim_day - r.opened_day - r.lost_days) );
+            }
+            CHECK( sum == supply, "balances add up to %lld, the supply is %lld", (long long)sum, (long long)supply );
+
+            const auto liability = token.liability( _sym );
+            CHECK( liability.ubi_accounts == ubi_rows, "the stat row counts %llu UBI accounts, there are %llu",
+                   (unsigned long long)liability.ubi_accounts, (unsigned long long)ubi_rows );
+
+            if (schedule::index_claim_days) {
+                const auto indexed = token.dormant( _sym, 0, 0xFFFF, pool_size + 1 );
+                CHECK( indexed.size() == ubi_rows, "the claim index has %zu rows, there are %llu UBI accounts",
+                       indexed.size(), (unsigned long long)ubi_rows );
+                for (const auto& d : indexed) {
+                    auto it = _model.rows.find( d.owner.value );
+                    CHECK( it != _model.rows.end() && it->second.claim_day == d.last_claim_day,
+                           "the claim index has day %u for %s", unsigned(d.last_claim_day), d.owner.to_string().c_str() );
+                }
+            }
+        }
+
+        template <typename... Args>
+        void log( const char* format, Args... args ) {
+            if (!_verbose)
+                return;
+            std::printf( format, args... );
+            std::printf( "\n" );
+        }
+
+        bool    _verbose;
+        symbol  _sym;
+        model   _model;
+};
+
+} /// namespace
+
+#ifdef REVELATION21_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput( const uint8_t* data, size_t size ) {
+    static sequence_runner runner( false );
+    const std::string failure = runner.run( data, size );
+    if (!failure.empty()) {
+        std::fprintf( stderr, "property broken: %s\n", failure.c_str() );
+        std::abort();
+    }
+    return 0;
+}
+
+#else
+
+namespace {
+
+struct options {
+    uint64_t     sequences = 100000;
+    uint32_t     length    = 48;
+    uint64_t     seed      = 21;
+    uint32_t     jobs      = 1;
+    std::string  replay;
+    bool         verbose   = false;
+};
+
+options parse_options( int argc, char** argv ) {
+    options o;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (!std::strcmp( arg, "--verbose" )) {
+            o.verbose = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::fprintf( stderr, "missing value of %s\n", arg );
+            std::exit( 1 );
+        }
+        const char* value = argv[++i];
+        if (!std::strcmp( arg, "--sequences" ))
+            o.sequences = std::strtoull( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--length" ))
+            o.length = std::strtoul( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--seed" ))
+            o.seed = std::strtoull( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--jobs" ))
+            o.jobs = std::max( 1ul, std::strtoul( value, nullptr, 10 ) );
+        else if (!std::strcmp( arg, "--replay" ))
+            o.replay = value;
+        else {
+            std::fprintf( stderr, "unknown option %s\n", arg );
+            std::exit( 1 );
+        }
+    }
+    return o;
+}
+
+std::string to_hex( const std::vector<uint8_t>& data ) {
+    static const char digits[] = "0123456789abcdef";
+    std::string s;
+    for (uint8_t b : data) {
+        s.push_back( digits[b >> 4] );
+        s.push_back( digits[b & 15] );
+    }
+    return s;
+}
+
+std::vector<uint8_t> from_hex( const std::string& s ) {
+    std::vector<uint8_t> data;
+    for (size_t i = 0; i + 1 < s.size(); i += 2)
+        data.push_back( uint8_t( std::stoul( s.substr( i, 2 ), nullptr, 16 ) ) );
+    return data;
+}
+
+// Runs "sequences" random inputs. Returns false at the first one that breaks a property.
+bool run_job( const options& opt, uint64_t seed, uint64_t sequences ) {
+    sequence_runner runner( false );
+    std::mt19937_64 rng( seed );
+    std::vector<uint8_t> input;
+    for (uint64_t i = 0; i < sequences; ++i) {
+        // Lengths vary, so that short sequences with few steps are tried as often as long ones.
+        input.resize( 3 + rng() % opt.length );
+        for (auto& b : input)
+            b = uint8_t( rng() );
+        const std::string failure = runner.run( input.data(), input.size() );
+        if (!failure.empty()) {
+            std::printf( "property broken: %s\ninput: %s\n", failure.c_str(), to_hex( input ).c_str() );
+            return false;
+        }
+    }
+    std::printf( "seed %llu: %llu sequences, %llu actions, %llu of them rejected\n", (unsigned long long)seed,
+                 (unsigned long long)sequences, (unsigned long long)runner.actions, (unsigned long long)runner.rejected );
+    return true;
+}
+
+} /// namespace
+
+int main( int argc, char** argv ) {
+    const options opt = parse_options( argc, argv );
+
+    if (!opt.replay.empty()) {
+        const std::vector<uint8_t> input = from_hex( opt.replay );
+        sequence_runner runner( opt.verbose );
+        const std::string failure = runner.run( input.data(), input.size() );
+        std::printf( "%s\n", failure.empty() ? "ok" : ("property broken: " + failure).c_str() );
+        return failure.empty() ? 0 : 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    bool ok = true;
+    if (opt.jobs == 1) {
+        ok = run_job( opt, opt.seed, opt.sequences );
+    } else {
+        // The native chain is a single instance per process: one process per job.
+        std::fflush( stdout );
+        for (uint32_t job = 0; job < opt.jobs; ++job) {
+            if (fork() == 0) {
+                const bool passed = run_job( opt, opt.seed + job, opt.sequences / opt.jobs + (job < opt.sequences % opt.jobs) );
+                std::fflush( stdout );
+                std::_Exit( passed ? 0 : 1 );
+            }
+        }
+        int status = 0;
+        while (wait( &status ) > 0)
+            ok = ok && WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+    }
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    std::printf( "%llu sequences in %.2f s (%.0f per second), %s\n", (unsigned long long)opt.sequences, seconds,
+                 seconds > 0 ? opt.sequences / seconds : 0.0, ok ? "no property broken" : "PROPERTY BROKEN" );
+    return ok ? 0 : 1;
+}
+
+#endif
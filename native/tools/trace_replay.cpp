@@ -0,0 +1,429 @@
+/**
+ * Replay of recorded revelation21 action traces on the native chain.
+ *
+ * Reads action traces exported from a history node, one JSON object per line, in execution order:
+ *
+ *   {"@timestamp": "2020-06-01T10:00:00.500", "trx_id": "...", "creator_action_ordinal": 0,
+ *    "act": {"account": "revelation21", "name": "transfer",
+ *            "authorization": [{"actor": "alice.jc", "permission": "active"}], "data": {...}}}
+ *
+ * ("block_time" or "timestamp" are read as well). Every top-level create, issue, retire, transfer,
+ *   transfermany, open and close of the contract is pushed as its own transaction, with the clock set
+ *   to its block time (shifted by --shift-days). Traces with a creator_action_ordinal are the inline
+ *   actions of the top-level action before them, and the inline actions the replay sends are compared
+ *   with them. An action that fails on replay, or whose inline actions differ, is a divergence.
+ *   Notification traces (receiver other than the contract) and actions of other contracts are skipped.
+ *
+ * Claim logs are not compared as inline actions: before claims were minted directly, a claim was an
+ *   inline issue() to the claimant, authorized by the contract, followed by the transfer() from the
+ *   issuer it sent, and later versions log it as an ubireceipt. Both are taken out of the recorded
+ *   and the replayed inline actions, and the quantity the recorded logs claimed is compared with the
+ *   supply the replayed action minted instead.
+ *
+ * Progress is printed every --progress actions. At the end the tool reports the DB operations per
+ *   action, the size of the contract state, and the supply and balances of every token; --balances
+ *   writes every final balance as CSV. The traces must start with the create of the tokens replayed,
+ *   since the replay starts from an empty chain.
+ *
+ *   revelation21_replay TRACES.jsonl|- [--contract NAME] [--shift-days N] [--progress N]
+ *                       [--max-divergences N] [--balances FILE]
+ */
+
+#include "json_reader.hpp"
+#include "token_driver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace eosio;
+using revelation21::token_driver;
+namespace json = revelation21::json;
+
+namespace {
+
+struct options {
+    const char* traces          = nullptr;
+    name        contract        = "revelation21"_n;
+    int64_t     shift_days      = 0;
+    uint64_t    progress        = 1000000;
+    uint64_t    max_divergences = 20;
+    const char* balances        = nullptr;
+};
+
+options parse_options( int argc, char** argv ) {
+    options o;
+    if (argc < 2) {
+        std::fprintf( stderr, "usage: %s TRACES.jsonl|- [--contract NAME] [--shift-days N] [--progress N]"
+                              " [--max-divergences N] [--balances FILE]\n", argv[0] );
+        std::exit( 1 );
+    }
+    o.traces = argv[1];
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const char* arg = argv[i];
+        const char* value = argv[i + 1];
+        if (!std::strcmp( arg, "--contract" ))
+            o.contract = name( value );
+        else if (!std::strcmp( arg, "--shift-days" ))
+            o.shift_days = std::strtoll( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--progress" ))
+            o.progress = std::strtoull( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--max-divergences" ))
+            o.max_divergences = std::strtoull( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--balances" ))
+            o.balances = value;
+        else {
+            std::fprintf( stderr, "unknown option %s\n", arg );
+            std::exit( 1 );
+        }
+    }
+    return o;
+}
+
+// "2020-06-01T10:00:00.500" (UTC) as microseconds since the epoch.
+uint64_t parse_time( const std::string& s ) {
+    int y, mo, d, h, mi, sec;
+    if (std::sscanf( s.c_str(), "%d-%d-%dT%d:%d:%d", &y, &mo, &d, &h, &mi, &sec ) != 6)
+        throw std::runtime_error( "not a block time: " + s );
+    // Days from the civil date, for the proleptic Gregorian calendar.
+    y -= mo <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const int64_t yoe = y - era * 400;
+    const int64_t doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int64_t days = era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+
+    uint64_t micros = 0;
+    const size_t dot = s.find( '.' );
+    if (dot != std::string::npos) {
+        uint64_t scale = 100000;
+        for (size_t i = dot + 1; i < s.size() && s[i] >= '0' && s[i] <= '9' && scale; ++i, scale /= 10)
+            micros += (s[i] - '0') * scale;
+    }
+    return uint64_t( ((days * 24 + h) * 60 + mi) * 60 + sec ) * 1000000 + micros;
+}
+
+const json::value* block_time( const json::value& trace ) {
+    for (const char* key : { "@timestamp", "block_time", "timestamp" })
+        if (const json::value* t = trace.find( key ))
+            return t;
+    return nullptr;
+}
+
+// The recorded action "act" as an action of the native chain, or nothing if the replay does not know it.
+//   Every account named by its data is added to "owners".
+std::optional<action> to_action( const json::value& act, std::unordered_set<uint64_t>& owners ) {
+    std::vector<permission_level> auths;
+    if (const json::value* a = act.find( "authorization" ))
+        for (const auto& auth : a->items)
+            auths.push_back( permission_level{ json::to_name( auth["actor"] ), json::to_name( auth["permission"] ) } );
+    const json::value& data = act["data"];
+    const name account = json::to_name( act["account"] );
+    const std::string& act_name = act["name"].as_string();
+
+    auto make = [&]( auto&&... args ) {
+        return std::optional<action>( action( auths, account, name( act_name ), std::make_tuple( args... ) ) );
+    };
+    auto owner = [&]( const char* field ) {
+        const name n = json::to_name( data[field] );
+        owners.insert( n.value );
+        return n;
+    };
+
+    if (act_name == "transfer")
+        return make( owner( "from" ), owner( "to" ), json::to_asset( data["quantity"] ), data["memo"].as_string() );
+    if (act_name == "transfermany") {
+        std::vector<token::payment> payments;
+        for (const auto& p : data["payments"].items) {
+            payments.push_back( token::payment{ json::to_name( p["to"] ), json::to_asset( p["quantity"] ), p["memo"].as_string() } );
+            owners.insert( payments.back().to.value );
+        }
+        return make( owner( "from" ), payments );
+    }
+    if (act_name == "open")
+        return make( owner( "owner" ), json::to_symbol( data["symbol"] ), owner( "ram_payer" ) );
+    if (act_name == "close")
+        return make( owner( "owner" ), json::to_symbol( data["symbol"] ) );
+    if (act_name == "issue")
+        return make( owner( "to" ), json::to_asset( data["quantity"] ), data["memo"].as_string() );
+    if (act_name == "retire")
+        return make( json::to_asset( data["quantity"] ), data["memo"].as_string() );
+    if (act_name == "create")
+        return make( owner( "issuer" ), json::to_asset( data["maximum_supply"] ) );
+    if (act_name == "ubireceipt")
+        return make( owner( "claimant" ), json::to_asset( data["quantity"] ), token::time_type( data["next_claim_day"].as_uint() ),
+                     token::time_type( data["lost_days"].as_uint() ) );
+    return std::nullopt;
+}
+
+// A top-level action read from the traces, with the inline actions recorded after it.
+struct recorded_action {
+    uint64_t                  line = 0;
+    uint64_t                  time = 0;
+    std::string               trx_id;
+    std::string               name;
+    std::optional<action>     act;
+    std::vector<std::string>  inline_names;
+    std::vector<std::optional<action>> inlines;
+    std::optional<asset>      claimed;          // by the claim logs among the recorded inline actions
+    std::optional<action>     claim_transfer;   // the transfer() the last claim issue() is expected to send
+};
+
+std::string describe( const std::vector<action>& inlines ) {
+    std::string s;
+    for (const auto& a : inlines)
+        s += (s.empty() ? "" : " ") + a.name.to_string();
+    return s.empty() ? "none" : s;
+}
+
+std::string describe( const std::vector<std::string>& names ) {
+    std::string s;
+    for (const auto& n : names)
+        s += (s.empty() ? "" : " ") + n;
+    return s.empty() ? "none" : s;
+}
+
+class replayer {
+    public:
+        replayer( const options& opt ) : _opt(opt), _chain(native::chain::instance()), _token(_chain, opt.contract) {
+            _chain.tracing = true;
+            _start = std::chrono::steady_clock::now();
+        }
+
+        void add_trace( const json::value& trace, uint64_t line ) {
+            const json::value& act = trace["act"];
+            if (json::to_name( act["account"] ) != _opt.contract) {
+                ++_other_contracts;
+                return;
+            }
+            if (const json::value* receiver = trace.find( "receiver" ))
+                if (json::to_name( *receiver ) != _opt.contract)
+                    return;
+
+            const json::value* creator = trace.find( "creator_action_ordinal" );
+            const json::value* trx = trace.find( "trx_id" );
+            if (creator && creator->as_uint() > 0) {
+                if (_pending && (!trx || trx->as_string() == _pending->trx_id) && !take_claim_log( *_pending, act )) {
+                    _pending->inline_names.push_back( act["name"].as_string() );
+                    _pending->inlines.push_back( to_action( act, _inline_owners ) );
+                }
+                return;
+            }
+
+            flush();
+            _pending.emplace();
+            _pending->line = line;
+            const json::value* t = block_time( trace );
+            if (!t)
+                throw std::runtime_error( "trace without a block time" );
+            _pending->time = parse_time( t->as_string() );
+            _pending->trx_id = trx ? trx->as_string() : std::string();
+            _pending->name = act["name"].as_string();
+            _pending->act = to_action( act, _owners );
+            if (_pending->act && _pending->name == "create")
+                _symbols.insert( json::to_asset( act["data"]["maximum_supply"] ).symbol.raw() );
+        }
+
+        // Replays the pending top-level action.
+        void flush() {
+            if (!_pending)
+                return;
+            recorded_action rec = std::move( *_pending );
+            _pending.reset();
+            if (!rec.act) {
+                ++_unsupported;
+                return;
+            }
+
+            _chain.set_time( rec.time + _opt.shift_days * int64_t(native::microseconds_per_day) );
+            const asset supply_before = rec.claimed ? _token.supply( rec.claimed->symbol ) : asset();
+            const native::push_result result = _chain.push_transaction( { *rec.act } );
+            ++_replayed;
+
+            std::vector<action> replayed;
+            for (const auto& a : _chain.trace.inlines)
+                if (a.name != "ubireceipt"_n)
+                    replayed.push_back( a );
+
+            if (!result)
+                diverged( rec, "failed: " + result.error );
+            else if (!same_inlines( rec, replayed ))
+                diverged( rec, "inline actions: recorded " + describe( rec.inline_names ) + ", replayed " + describe( replayed ) );
+            else if (rec.claimed && _token.supply( rec.claimed->symbol ) - supply_before != *rec.claimed)
+                diverged( rec, "claimed " + rec.claimed->to_string() + ", replayed " +
+                               (_token.supply( rec.claimed->symbol ) - supply_before).to_string() );
+
+            if (_opt.progress && _replayed % _opt.progress == 0)
+                print_progress();
+        }
+
+        int finish() {
+            flush();
+            print_progress();
+            const double seconds = elapsed();
+
+            std::printf( "\nreplayed %llu actions in %.1f s (%.0f per minute), %llu unsupported, %llu of other contracts\n",
+                         (unsigned long long)_replayed, seconds, seconds > 0 ? _replayed * 60.0 / seconds : 0.0,
+                         (unsigned long long)_unsupported, (unsigned long long)_other_contracts );
+            std::printf( "divergences: %llu\n\n", (unsigned long long)_divergences );
+
+            std::printf( "%-12s %10s %8s %7s %7s %7s %7s %7s\n", "action", "count", "failed", "reads", "writes", "notifs", "inlines", "bytes" );
+            for (const auto& s : _chain.stats) {
+                const auto& st = s.second;
+                const double n = st.count ? double(st.count) : 1.0;
+                std::printf( "%-12s %10llu %8llu %7.2f %7.2f %7.2f %7.2f %7.1f\n", name( s.first ).to_string().c_str(),
+                             (unsigned long long)st.count, (unsigned long long)st.failed, st.db_reads / n, st.db_writes / n,
+                             st.notifications / n, st.inline_actions / n, st.data_bytes / n );
+            }
+
+            std::printf( "\nstate: %zu rows in %zu tables, %lld bytes of rows, %lld bytes of billable RAM\n",
+                         _chain.db.row_count(), _chain.db.table_count(), (long long)_chain.db.row_bytes(), (long long)_chain.db.ram_bytes );
+
+            std::FILE* balances = nullptr;
+            if (_opt.balances && !(balances = std::fopen( _opt.balances, "w" ))) {
+                std::fprintf( stderr, "cannot write %s\n", _opt.balances );
+                return 1;
+            }
+            std::vector<uint64_t> owners( _owners.begin(), _owners.end() );
+            std::sort( owners.begin(), owners.end() );
+            for (uint64_t raw : _symbols) {
+                const symbol sym( raw );
+                asset sum{ 0, sym };
+                uint64_t holders = 0;
+                for (uint64_t owner : owners) {
+                    const asset balance = _token.balance( name( owner ), sym );
+                    if (balance.amount == 0)
+                        continue;
+                    ++holders;
+                    sum += balance;
+                    if (balances)
+                        std::fprintf( balances, "%s,%s\n", name( owner ).to_string().c_str(), balance.to_string().c_str() );
+                }
+                const asset supply = _token.supply( sym );
+                std::printf( "%s: supply %s, %llu holders holding %s  %s\n", sym.code().to_string().c_str(), supply.to_string().c_str(),
+                             (unsigned long long)holders, sum.to_string().c_str(), sum == supply ? "ok" : "MISMATCH" );
+            }
+            if (balances)
+                std::fclose( balances );
+            return 0;
+        }
+
+    private:
+        // Adds the inline action "act" to the claim of "rec" if it is a claim log (see above), and returns
+        //   whether it was.
+        bool take_claim_log( recorded_action& rec, const json::value& act ) {
+            const std::string& act_name = act["name"].as_string();
+            const json::value& data = act["data"];
+            if (act_name == "transfer" && rec.claim_transfer) {
+                std::unordered_set<uint64_t> owners;
+                const std::optional<action> transfer = to_action( act, owners );
+                if (transfer && transfer->data == rec.claim_transfer->data) {
+                    rec.claim_transfer.reset();
+                    return true;
+                }
+            }
+
+            asset quantity;
+            if (act_name == "issue" && rec.name != "issue") {
+                const json::value* auth = act.find( "authorization" );
+                if (!auth || auth->items.size() != 1 || json::to_name( auth->items[0]["actor"] ) != _opt.contract)
+                    return false;
+                quantity = json::to_asset( data["quantity"] );
+                // Sent from the issuer of the token, which is the contract for the tokens that claim.
+                rec.claim_transfer = action( permission_level{ _opt.contract, "active"_n }, _opt.contract, "transfer"_n,
+                                             std::make_tuple( _opt.contract, json::to_name( data["to"] ), quantity,
+                                                              data["memo"].as_string() ) );
+            } else if (act_name == "ubireceipt") {
+                quantity = json::to_asset( data["quantity"] );
+            } else {
+                return false;
+            }
+            if (rec.claimed)
+                *rec.claimed += quantity;
+            else
+                rec.claimed = quantity;
+            return true;
+        }
+
+        // Inline actions the replay cannot encode are only compared by name.
+        static bool same_inlines( const recorded_action& rec, const std::vector<action>& replayed ) {
+            if (rec.inlines.size() != replayed.size())
+                return false;
+            for (size_t i = 0; i < replayed.size(); ++i) {
+                if (rec.inline_names[i] != replayed[i].name.to_string())
+                    return false;
+                if (rec.inlines[i] && rec.inlines[i]->data != replayed[i].data)
+                    return false;
+            }
+            return true;
+        }
+
+        void diverged( const recorded_action& rec, const std::string& what ) {
+            if (++_divergences <= _opt.max_divergences)
+                std::printf( "line %llu: %s %s: %s\n", (unsigned long long)rec.line, rec.name.c_str(),
+                             rec.trx_id.empty() ? "" : rec.trx_id.c_str(), what.c_str() );
+        }
+
+        double elapsed()const {
+            return std::chrono::duration<double>( std::chrono::steady_clock::now() - _start ).count();
+        }
+
+        void print_progress() {
+            const double seconds = elapsed();
+            std::printf( "%llu actions, day %u, %llu divergences, %zu rows, %lld bytes of RAM, %.0f actions per minute\n",
+                         (unsigned long long)_replayed, _chain.day(), (unsigned long long)_divergences, _chain.db.row_count(),
+                         (long long)_chain.db.ram_bytes, seconds > 0 ? _replayed * 60.0 / seconds : 0.0 );
+            std::fflush( stdout );
+        }
+
+        const options&                  _opt;
+        native::chain&                  _chain;
+        token_driver                    _token;
+        std::optional<recorded_action>  _pending;
+        std::unordered_set<uint64_t>    _owners;
+        std::unordered_set<uint64_t>    _inline_owners;
+        std::set<uint64_t>              _symbols;
+        uint64_t                        _replayed = 0;
+        uint64_t                        _unsupported = 0;
+        uint64_t                        _other_contracts = 0;
+        uint64_t                        _divergences = 0;
+        std::chrono::steady_clock::time_point _start;
+};
+
+} /// namespace
+
+int main( int argc, char** argv ) {
+    const options opt = parse_options( argc, argv );
+
+    std::ifstream file;
+    if (std::strcmp( opt.traces, "-" ) != 0) {
+        file.open( opt.traces );
+        if (!file) {
+            std::fprintf( stderr, "cannot read %s\n", opt.traces );
+            return 1;
+        }
+    }
+    std::istream& in = file.is_open() ? static_cast<std::istream&>( file ) : std::cin;
+
+    replayer replay( opt );
+    std::string line;
+    uint64_t line_number = 0;
+    try {
+        while (std::getline( in, line )) {
+            ++line_number;
+            if (line.find_first_not_of( " \t\r" ) != std::string::npos)
+                replay.add_trace( json::parse( line ), line_number );
+        }
+    } catch (const std::exception& e) {
+        std::fprintf( stderr, "%s:%llu: %s\n", opt.traces, (unsigned long long)line_number, e.what() );
+        return 1;
+    }
+    return replay.finish();
+}
@@ -0,0 +1,474 @@
+/**
+ * Deterministic time-travel simulator of the supply and RAM growth of a revelation21 token.
+ *
+ * Projects a token over tens of years under a UBI schedule and a population model, without a chain:
+ *   holders arrive every day, claim at their own pace, and some leave by emptying and closing their
+ *   balance. Every claim is paid by token::compute_claim(), with the claim_days and max_past_claim_days
+ *   of the schedule being projected, so the projection follows the contract's claim arithmetic (back
+ *   pay on open, lost days, whole days only against max_supply). The RAM of a holder is measured once
+ *   on the native chain, by opening balances with the contract.
+ *
+ * The population model of a scenario:
+ *   - Poisson arrivals of "--arrivals" holders a day, after "--holders" opened on the first day. A
+ *     share "--ubi" of them can claim UBI.
+ *   - Every UBI holder claims on open. A share "--dormant" of them never claims again; the others
+ *     claim after geometric intervals, with a mean drawn for every holder from an exponential
+ *     distribution of mean "--claim-interval" days.
+ *   - Every day, a holder leaves with probability "--churn": it transfers its balance away (which
+ *     claims) and closes the balance row as soon as close() lets it.
+ *
+ * Every option that sets a scenario parameter takes a comma-separated list, and the simulator runs
+ *   every combination of them, spread over "--threads" threads. Scenarios are seeded by their index,
+ *   so the results do not depend on the thread count. Populations larger than "--sample" holders are
+ *   simulated by a sample of that many, each holder standing for several.
+ *
+ *   revelation21_simulate [--schedule heart,kyc_monthly,open_chain] [--claim-days N,..] [--max-past N,..]
+ *                         [--arrivals N,..] [--holders N,..] [--ubi F,..] [--claim-interval N,..]
+ *                         [--dormant F,..] [--churn F,..] [--max-supply N,..] [--years N] [--start DAY]
+ *                         [--sample N] [--step DAYS] [--seed N] [--threads N] [--curves FILE.csv]
+ *
+ * It prints one line per scenario, and "--curves" writes the supply, lost days, liability, holders
+ *   and billable RAM of every scenario every "--step" days.
+ */
+
+#include "token_driver.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace eosio;
+using revelation21::token_driver;
+using time_type = eosio::token::time_type;
+
+namespace {
+
+struct schedule {
+    std::string name;
+    time_type   first_claim_day;
+    bool        grace_period;
+    int64_t     claim_days;
+    int64_t     max_past_claim_days;
+    bool        index_claim_days;
+};
+
+template <typename Config>
+schedule schedule_of( const char* name ) {
+    return schedule{ name, Config::first_claim_day, Config::unbounded_UBI_account_creation, Config::claim_days,
+                     Config::max_past_claim_days, Config::index_claim_days };
+}
+
+bool find_schedule( const std::string& name, schedule& s ) {
+    if (name == "heart")
+        s = schedule_of<ubi_config::heart>( "heart" );
+    else if (name == "kyc_monthly")
+        s = schedule_of<ubi_config::kyc_monthly>( "kyc_monthly" );
+    else if (name == "open_chain")
+        s = schedule_of<ubi_config::open_chain>( "open_chain" );
+    else
+        return false;
+    return true;
+}
+
+struct scenario {
+    schedule sched;
+    double   arrivals;       // new holders a day
+    double   holders;        // holders opened on the first day
+    double   ubi_share;
+    double   claim_interval; // mean days between two claims of an active holder
+    double   dormant;
+    double   churn;          // probability that a holder leaves on a given day
+    int64_t  max_supply;     // whole tokens
+};
+
+struct options {
+    std::vector<std::string> schedules{ "heart" };
+    std::vector<double> claim_days, max_past;
+    std::vector<double> arrivals{ 100 }, holders{ 0 }, ubi{ 0.75 }, claim_interval{ 7 }, dormant{ 0.2 }, churn{ 0.0002 };
+    std::vector<double> max_supply{ 2100000000 };
+    uint32_t years   = 20;
+    time_type start  = 20454; // 1 January 2026
+    uint32_t sample  = 20000;
+    uint32_t step    = 365;
+    uint64_t seed    = 21;
+    uint32_t threads = std::max( 1u, std::thread::hardware_concurrency() );
+    const char* curves = nullptr;
+};
+
+std::vector<double> parse_list( const char* arg ) {
+    std::vector<double> values;
+    for (const char* p = arg; *p; ) {
+        char* end;
+        values.push_back( std::strtod( p, &end ) );
+        if (end == p)
+            break;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+std::vector<std::string> parse_names( const char* arg ) {
+    std::vector<std::string> names;
+    std::string s = arg;
+    for (size_t pos = 0; pos <= s.size(); ) {
+        const size_t comma = std::min( s.find( ',', pos ), s.size() );
+        names.push_back( s.substr( pos, comma - pos ) );
+        pos = comma + 1;
+    }
+    return names;
+}
+
+options parse_options( int argc, char** argv ) {
+    options o;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* arg = argv[i];
+        const char* value = argv[i + 1];
+        if (!std::strcmp( arg, "--schedule" ))
+            o.schedules = parse_names( value );
+        else if (!std::strcmp( arg, "--claim-days" ))
+            o.claim_days = parse_list( value );
+        else if (!std::strcmp( arg, "--max-past" ))
+            o.max_past = parse_list( value );
+        else if (!std::strcmp( arg, "--arrivals" ))
+            o.arrivals = parse_list( value );
+        else if (!std::strcmp( arg, "--holders" ))
+            o.holders = parse_list( value );
+        else if (!std::strcmp( arg, "--ubi" ))
+            o.ubi = parse_list( value );
+        else if (!std::strcmp( arg, "--claim-interval" ))
+            o.claim_interval = parse_list( value );
+        else if (!std::strcmp( arg, "--dormant" ))
+            o.dormant = parse_list( value );
+        else if (!std::strcmp( arg, "--churn" ))
+            o.churn = parse_list( value );
+        else if (!std::strcmp( arg, "--max-supply" ))
+            o.max_supply = parse_list( value );
+        else if (!std::strcmp( arg, "--years" ))
+            o.years = std::strtoul( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--start" ))
+            o.start = std::strtoul( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--sample" ))
+            o.sample = std::strtoul( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--step" ))
+            o.step = std::strtoul( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--seed" ))
+            o.seed = std::strtoull( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--threads" ))
+            o.threads = std::strtoul( value, nullptr, 10 );
+        else if (!std::strcmp( arg, "--curves" ))
+            o.curves = value;
+        else {
+            std::fprintf( stderr, "unknown option %s\n", arg );
+            std::exit( 1 );
+        }
+    }
+    return o;
+}
+
+// Every combination of the listed parameters, schedules outermost.
+std::vector<scenario> expand( const options& o ) {
+    std::vector<scenario> out;
+    for (const auto& name : o.schedules) {
+        schedule base;
+        if (!find_schedule( name, base )) {
+            std::fprintf( stderr, "unknown schedule %s\n", name.c_str() );
+            std::exit( 1 );
+        }
+        const std::vector<double> claim_days = o.claim_days.empty() ? std::vector<double>{ double(base.claim_days) } : o.claim_days;
+        const std::vector<double> max_past = o.max_past.empty() ? std::vector<double>{ double(base.max_past_claim_days) } : o.max_past;
+        for (double cd : claim_days)
+        for (double mp : max_past)
+        for (double arrivals : o.arrivals)
+        for (double holders : o.holders)
+        for (double ubi : o.ubi)
+        for (double interval : o.claim_interval)
+        for (double dormant : o.dormant)
+        for (double churn : o.churn)
+        for (double max_supply : o.max_supply) {
+            schedule s = base;
+            s.claim_days = int64_t(cd);
+            s.max_past_claim_days = int64_t(mp);
+            // The same limits ubi_config::check() puts on a schedule.
+            if (s.claim_days < 1 || s.max_past_claim_days < 0 || s.max_past_claim_days + s.claim_days > 0xFFFF) {
+                std::fprintf( stderr, "invalid schedule: claim days %lld, max past %lld\n",
+                              (long long)s.claim_days, (long long)s.max_past_claim_days );
+                std::exit( 1 );
+            }
+            out.push_back( scenario{ s, arrivals, holders, ubi, std::max( 1.0, interval ), dormant, churn, int64_t(max_supply) } );
+        }
+    }
+    return out;
+}
+
+// Billable RAM of the rows of one holder, as the contract bills them on the native chain.
+struct holder_ram {
+    int64_t plain;       // balance row of an account that cannot claim UBI
+    int64_t ubi;         // balance row with a claim day
+    int64_t index;       // claimindex row of an UBI account, included in "ubi"
+    int64_t contract;    // stat row, supply shards and everything else create() and the first claims add
+};
+
+// Opens a few balances with the contract built for the native chain and reads what each costs its payer.
+holder_ram measure_holder_ram( const symbol& sym ) {
+    native::chain& c = native::chain::instance();
+    c.reset();
+    token_driver token( c );
+    c.set_day( 18047 + 1000 );
+    holder_ram ram{};
+    if (!token.create( token.contract(), asset{ int64_t(1000000000) * 10000, sym } )) {
+        std::fprintf( stderr, "create failed\n" );
+        std::exit( 1 );
+    }
+    for (const char* owner : { "simplain", "simplain2", "simubi.jc", "simubi2.jc" }) {
+        if (!token.open( name( owner ), sym, name( owner ) )) {
+            std::fprintf( stderr, "open %s failed\n", owner );
+            std::exit( 1 );
+        }
+    }
+    // The second UBI balance, as the first one also pays for the claimindex table of the token.
+    ram.plain = c.db.ram_usage[name( "simplain2" ).value];
+    ram.ubi = c.db.ram_usage[name( "simubi2.jc" ).value];
+    // The claim day is a 16-bit binary extension of the balance row.
+    ram.index = ram.ubi - ram.plain - int64_t(sizeof(time_type));
+    ram.contract = c.db.ram_bytes - 2 * (ram.plain + ram.ubi);
+    c.reset();
+    return ram;
+}
+
+struct sample_point {
+    uint32_t day;
+    double   holders;
+    double   ubi_holders;
+    double   supply;         // tokens
+    double   lost_days;
+    double   unclaimed_days; // upper bound of the outstanding UBI, as token::get_liability() computes it
+    double   ram_bytes;
+};
+
+struct result {
+    std::vector<sample_point> curve;
+    double   claims = 0;
+    int64_t  capped_day = -1; // first day a claim was cut short by max_supply
+    double   seconds = 0;
+};
+
+struct sim_holder {
+    time_type claim_day;     // 0 for accounts that cannot claim UBI
+    uint32_t  close_day;     // simulation day the holder empties its balance
+    float     log_skip;      // log of the probability of not claiming on a given day, 0 for dormant holders
+    bool      leaving;
+};
+
+result simulate( const scenario& sc, const options& o, const holder_ram& ram, uint64_t index ) {
+    const auto started = std::chrono::steady_clock::now();
+    result r;
+    std::mt19937_64 rng( o.seed * 0x9E3779B97F4A7C15ull + index );
+    std::uniform_real_distribution<double> uniform( 0.0, 1.0 );
+    std::exponential_distribution<double> interval( 1.0 / sc.claim_interval );
+
+    const symbol sym( "SIM", 4 );
+    const int64_t unit = ubi_config::precision_multipliers[sym.precision()];
+    const uint32_t days = o.years * 365;
+    const time_type first_day = sc.sched.first_claim_day + (sc.sched.grace_period ? 2 : 0);
+
+    // Every simulated holder stands for "weight" holders.
+    const double expected = sc.holders + sc.arrivals * days;
+    const double weight = expected > o.sample ? expected / o.sample : 1.0;
+    const int64_t index_ram = sc.sched.index_claim_days ? ram.index : 0;
+
+    // Days are numbered from "o.start"; events[d] holds the holders to look at on that day.
+    std::vector<std::vector<uint32_t>> events( days + 1 );
+    std::vector<sim_holder> holders;
+    holders.reserve( size_t(std::min( expected / weight * 1.1, 1e8 )) + 16 );
+
+    double supply = 0, lost_days = 0, open_plain = 0, open_ubi = 0, claim_day_sum = 0;
+
+    auto claim = [&]( sim_holder& h, time_type today ) {
+        const int64_t available = int64_t( std::max( 0.0, double(sc.max_supply) * unit - supply ) / weight );
+        const auto c = eosio::token::compute_claim( h.claim_day, today, sym, available,
+                                                    sc.sched.claim_days, sc.sched.max_past_claim_days );
+        if (c.quantity.amount == 0 && c.lost_days == 0) {
+            if (h.claim_day < today && r.capped_day < 0)
+                r.capped_day = today;
+            return;
+        }
+        if (r.capped_day < 0 && c.next_claim_day < today - 1 + sc.sched.claim_days)
+            r.capped_day = today;
+        supply += double(c.quantity.amount) * weight;
+        lost_days += double(c.lost_days) * weight;
+        claim_day_sum += (double(c.next_claim_day) - h.claim_day) * weight;
+        h.claim_day = c.next_claim_day;
+        r.claims += weight;
+    };
+
+    // The next day something happens to holder "i": its next claim, or the day it leaves.
+    auto schedule_next = [&]( uint32_t i, uint32_t d ) {
+        sim_holder& h = holders[i];
+        int64_t next = h.close_day;
+        if (h.leaving) {
+            // close() waits until the income of today has not been claimed yet.
+            next = std::max<int64_t>( d + 1, h.claim_day ? int64_t(h.claim_day) + 1 - o.start : 0 );
+        } else if (h.log_skip < 0) {
+            // A geometric gap, drawn by inversion: cheaper than a geometric_distribution per holder.
+            const double gap = std::floor( std::log( 1.0 - uniform( rng ) ) / h.log_skip );
+            next = std::min<int64_t>( next, int64_t(d) + 1 + int64_t( std::min( gap, 1e9 ) ) );
+        }
+        if (next <= days)
+            events[next].push_back( i );
+    };
+
+    auto open = [&]( uint32_t d ) {
+        const time_type today = time_type( o.start + d );
+        sim_holder h{ 0, UINT32_MAX, 0.0f, false };
+        if (sc.churn > 0) {
+            std::geometric_distribution<uint32_t> stay( std::min( sc.churn, 1.0 ) );
+            h.close_day = uint32_t( std::min<uint64_t>( uint64_t(d) + 1 + stay( rng ), UINT32_MAX ) );
+        }
+        if (uniform( rng ) < sc.ubi_share) {
+            // With the grace period, a new row is paid from the day after tomorrow at the earliest.
+            h.claim_day = sc.sched.grace_period ? std::max<time_type>( first_day, today + 1 ) : first_day;
+            claim_day_sum += double(h.claim_day) * weight;
+            open_ubi += weight;
+            if (uniform( rng ) >= sc.dormant)
+                h.log_skip = float( std::log1p( -1.0 / (1.0 + interval( rng )) ) );
+            // open() claims right away.
+            claim( h, today );
+        } else {
+            open_plain += weight;
+        }
+        holders.push_back( h );
+        schedule_next( uint32_t(holders.size() - 1), d );
+    };
+
+    auto sample = [&]( uint32_t d ) {
+        const double ubi_rows = open_ubi;
+        const double liability = ubi_rows * (double(o.start + d) - 1 + sc.sched.claim_days) - claim_day_sum;
+        r.curve.push_back( sample_point{ o.start + d, open_plain + open_ubi, open_ubi, supply / unit, lost_days,
+                                         std::max( 0.0, liability ),
+                                         double(ram.contract) + open_plain * ram.plain + open_ubi * (ram.ubi - ram.index + index_ram) } );
+    };
+
+    // poisson_distribution needs a positive mean.
+    std::poisson_distribution<uint32_t> arrivals( std::max( sc.arrivals / weight, 1e-12 ) );
+    for (uint32_t n = uint32_t( std::llround( sc.holders / weight ) ); n > 0; --n)
+        open( 0 );
+    for (uint32_t d = 0; d <= days; ++d) {
+        const time_type today = time_type( o.start + d );
+        if (d > 0 && sc.arrivals > 0) {
+            for (uint32_t n = arrivals( rng ); n > 0; --n)
+                open( d );
+        }
+        // Holders opened above may have added themselves to today's list; they are handled tomorrow.
+        std::vector<uint32_t> due;
+        due.swap( events[d] );
+        for (uint32_t i : due) {
+            sim_holder& h = holders[i];
+            if (h.leaving) {
+                if (h.claim_day && h.claim_day >= today) {
+                    schedule_next( i, d );
+                    continue;
+                }
+                // Closed: the balance went to a holder that stays, and the rows are deleted.
+                if (h.claim_day) {
+                    open_ubi -= weight;
+                    claim_day_sum -= double(h.claim_day) * weight;
+                } else {
+                    open_plain -= weight;
+                }
+                continue;
+            }
+            if (d >= h.close_day) {
+                // The transfer that empties the balance claims first.
+                if (h.claim_day)
+                    claim( h, today );
+                h.leaving = true;
+            } else if (h.claim_day) {
+                claim( h, today );
+            }
+            schedule_next( i, d );
+        }
+        if (d % o.step == 0 || d == days)
+            sample( d );
+    }
+
+    r.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - started ).count();
+    return r;
+}
+
+} /// namespace
+
+int main( int argc, char** argv ) {
+    const options opt = parse_options( argc, argv );
+    const std::vector<scenario> scenarios = expand( opt );
+    if (opt.step == 0 || opt.years == 0 || opt.sample == 0) {
+        std::fprintf( stderr, "--years, --step and --sample must be at least 1\n" );
+        return 1;
+    }
+    // Claim days are 16-bit, and a claim moves one up to claim_days - 1 days past today.
+    int64_t max_claim_days = 0;
+    for (const auto& sc : scenarios)
+        max_claim_days = std::max( max_claim_days, sc.sched.claim_days );
+    if (opt.start + int64_t(opt.years) * 365 + max_claim_days > 0xFFFF) {
+        std::fprintf( stderr, "the last day of the simulation does not fit a 16-bit day\n" );
+        return 1;
+    }
+
+    const holder_ram ram = measure_holder_ram( symbol( "SIM", 4 ) );
+    std::printf( "holder RAM: %lld bytes without UBI, %lld with UBI (%lld of them the claimindex row), contract %lld\n",
+                 (long long)ram.plain, (long long)ram.ubi, (long long)ram.index, (long long)ram.contract );
+
+    std::vector<result> results( scenarios.size() );
+    std::atomic<size_t> next{ 0 };
+    const uint32_t threads = std::max<uint32_t>( 1, std::min<size_t>( opt.threads, scenarios.size() ) );
+    const auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (uint32_t w = 0; w < threads; ++w) {
+        workers.emplace_back( [&]() {
+            for (size_t i = next++; i < scenarios.size(); i = next++)
+                results[i] = simulate( scenarios[i], opt, ram, i );
+        });
+    }
+    for (auto& t : workers)
+        t.join();
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - started ).count();
+
+    std::printf( "%zu scenarios of %u years, %u threads, %.2f s\n\n", scenarios.size(), opt.years, threads, seconds );
+    std::printf( "%5s %-11s %5s %6s %9s %9s %5s %5s %5s %8s %13s | %11s %15s %9s %15s %15s %13s\n",
+                 "id", "schedule", "claim", "past", "arrivals", "holders", "ubi", "every", "dorm", "churn", "max_supply",
+                 "holders", "supply", "capped", "lost_days", "unclaimed_days", "ram_bytes" );
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        const scenario& sc = scenarios[i];
+        const sample_point& end = results[i].curve.back();
+        char capped[24] = "-";
+        if (results[i].capped_day >= 0)
+            std::snprintf( capped, sizeof(capped), "%lld", (long long)results[i].capped_day );
+        std::printf( "%5zu %-11s %5lld %6lld %9.1f %9.0f %5.2f %5.1f %5.2f %8.5f %13lld | %11.0f %15.0f %9s %15.0f %15.0f %13.0f\n",
+                     i, sc.sched.name.c_str(), (long long)sc.sched.claim_days, (long long)sc.sched.max_past_claim_days,
+                     sc.arrivals, sc.holders, sc.ubi_share, sc.claim_interval, sc.dormant, sc.churn, (long long)sc.max_supply,
+                     end.holders, end.supply, capped, end.lost_days, end.unclaimed_days, end.ram_bytes );
+    }
+
+    if (opt.curves) {
+        FILE* f = std::fopen( opt.curves, "w" );
+        if (!f) {
+            std::fprintf( stderr, "cannot write %s\n", opt.curves );
+            return 1;
+        }
+        std::fprintf( f, "scenario,day,holders,ubi_holders,supply,lost_days,unclaimed_days,ram_bytes\n" );
+        for (size_t i = 0; i < scenarios.size(); ++i) {
+            for (const auto& p : results[i].curve)
+                std::fprintf( f, "%zu,%u,%.0f,%.0f,%.4f,%.0f,%.0f,%.0f\n", i, p.day, p.holders, p.ubi_holders, p.supply,
+                              p.lost_days, p.unclaimed_days, p.ram_bytes );
+        }
+        std::fclose( f );
+    }
+    return 0;
+}
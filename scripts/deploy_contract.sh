@@ -14,7 +14,14 @@ fi
 revelation21_HOME=../src/revelation21
 echo "-------- revelation21 ---------"
 cd $revelation21_HOME
-eosio-cpp -o revelation21.wasm revelation21.cpp --abigen
+eosio-cpp -DUBI_CONFIG=${UBI_CONFIG:-heart} -o revelation21.wasm revelation21.cpp --abigen || exit 1
+# Records the sources next to the WASM, then checks the budgets. REVELATION21_BUDGET_FLAGS is passed on to
+#   the check, e.g. "--allow-uncounted" where perf_event_open is not allowed. After a deliberate change of
+#   the WASM sizes, "cmake --build build --target set_wasm_budgets" sets them as the new budgets.
+cmake -S ../.. -B ../../build -DREVELATION21_WASM_CONFIG=${UBI_CONFIG:-heart} \
+   -DREVELATION21_BUDGET_FLAGS="$REVELATION21_BUDGET_FLAGS" > /dev/null || exit 1
+cmake --build ../../build --target record_wasm_sources || exit 1
+cmake --build ../../build --target check_budgets || { echo "revelation21 is over budget, see native/budgets.txt"; exit 1; }
 echo "$ cleos $NET set contract revelation21 $PWD -p revelation21@active"
 cleos $NET set contract revelation21 $PWD -p revelation21@active
 
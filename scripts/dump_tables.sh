@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Dumps the accounts, extras, stat and supplyshard tables of the contract, one line of JSON per scope
+#   and table, for the offline snapshot tool (native/tools/table_snapshot.cpp):
+#
+#   ./dump_tables.sh [prod|test] > tables.jsonl
+#   revelation21_snapshot import tables.jsonl tables.r21
+#   revelation21_snapshot report tables.r21
+#
+# The balances are scoped by owner, so the dump still makes one get table call per holder, on top of
+#   one get scope call per thousand holders: with a million holders, it takes hours against a public
+#   endpoint. Point it at a node of your own for large dumps. Only the import and report are offline.
+#
+# Needs jq.
+
+NET=
+
+if [ "$1" == "prod" ]; then
+   NET='--url https://telos.eos.barcelona'
+fi
+
+if [ "$1" == "test" ]; then
+   NET='--url https://testnet.telos.caleos.io'
+fi
+
+CHUNK=1000
+
+for TABLE in accounts extras stat supplyshard; do
+   LOWER=
+   while true; do
+      if [ -z "$LOWER" ]; then
+         SCOPES=$(cleos $NET get scope revelation21 -t $TABLE -l $CHUNK) || exit 1
+      else
+         SCOPES=$(cleos $NET get scope revelation21 -t $TABLE -l $CHUNK -L $LOWER) || exit 1
+      fi
+      for SCOPE in $(echo "$SCOPES" | jq -r '.rows[].scope'); do
+         cleos $NET get table revelation21 $SCOPE $TABLE -l $CHUNK \
+            | jq -c --arg table $TABLE --arg scope $SCOPE '{table: $table, scope: $scope, rows: .rows}' || exit 1
+      done
+      LOWER=$(echo "$SCOPES" | jq -r '.more // empty')
+      if [ -z "$LOWER" ]; then
+         break
+      fi
+   done
+done
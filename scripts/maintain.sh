@@ -0,0 +1,51 @@
+#!/bin/bash
+
+# Keeper for the maintain() action: walks the scopes of a table of the contract in chunks and runs
+#   one maintenance pass over them, resuming from the cursor saved by the contract after each call.
+#
+#   ./maintain.sh [prod|test] [pass] [table] [chunk]
+#
+# pass: 0 = cleanup, 1 = audit, 2 = migrate, 3 = index. Sweep "extras" with the cleanup pass to also
+#   reach the orphaned extras rows, and with the migrate pass after an upgrade from the "extras" layout
+#   ("./maintain.sh prod 2 extras"): only the scopes that still have extras rows need migrating.
+# Needs jq, and a "maintain" permission of revelation21 linked to the action.
+
+NET=
+
+if [ "$1" == "prod" ]; then
+   NET='--url https://telos.eos.barcelona'
+fi
+
+if [ "$1" == "test" ]; then
+   NET='--url https://testnet.telos.caleos.io'
+fi
+
+PASS=${2:-0}
+TABLE=${3:-accounts}
+CHUNK=${4:-100}
+SYMBOL=HEART
+
+RESTART=true
+LOWER=
+while true; do
+   if [ -z "$LOWER" ]; then
+      SCOPES=$(cleos $NET get scope revelation21 -t $TABLE -l $CHUNK)
+   else
+      SCOPES=$(cleos $NET get scope revelation21 -t $TABLE -l $CHUNK -L $LOWER)
+   fi
+   OWNERS=$(echo "$SCOPES" | jq -c '[.rows[].scope]')
+   LAST=$(echo "$SCOPES" | jq -r '.rows[-1].scope // empty')
+   MORE=$(echo "$SCOPES" | jq -r '.more')
+   if [ -z "$LAST" ]; then
+      break
+   fi
+
+   cleos $NET push action revelation21 maintain "[\"$SYMBOL\", $PASS, $RESTART, $OWNERS, $((CHUNK * 4))]" -p revelation21@maintain || exit 1
+   RESTART=false
+
+   CURSOR=$(cleos $NET get table revelation21 $SYMBOL maintenance | jq -r '.rows[0].cursor')
+   if [ "$CURSOR" == "$LAST" ] && [ -z "$MORE" ]; then
+      break
+   fi
+   LOWER=$CURSOR
+done
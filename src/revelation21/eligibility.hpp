@@ -0,0 +1,140 @@
+/**
+ * UBI eligibility policies for the token contract.
+ *
+ * A policy is a type with a static "bool check( name contract, name account )" that tells whether
+ *   "account" can claim UBI from the token deployed at "contract". Policies are combined at compile
+ *   time with all_of, any_of and not_, so the contract pays only for the checks it actually uses:
+ *   a few integer operations for name_suffix, and one table read for the list and registry policies.
+ */
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/multi_index.hpp>
+
+namespace eosio { namespace eligibility {
+
+    namespace detail {
+        // Number of characters of an encoded name, i.e. the position of its last non-dot character.
+        constexpr uint32_t name_length( uint64_t value ) {
+            if (value == 0) return 0;
+            if (value & 0x0Full) return 13;
+            return (63 - __builtin_ctzll( value )) / 5 + 1;
+        }
+
+        constexpr uint64_t low_bits( uint32_t n ) {
+            return n >= 64 ? ~0ull : (1ull << n) - 1;
+        }
+    }
+
+    // Accounts whose name ends with the characters of "Suffix", given as the value of a name
+    //   (e.g. name_suffix<".jc"_n.value> for every account ending with ".jc"). The suffix alone is
+    //   not a match: at least one character has to come before it.
+    template <uint64_t Suffix>
+    struct name_suffix {
+        static constexpr uint32_t suffix_length = detail::name_length( Suffix );
+        static_assert( suffix_length > 0 && suffix_length < 13, "invalid name suffix" );
+
+        // The suffix characters, 5 bits each, the last one in the lowest bits.
+        static constexpr uint64_t suffix_bits = Suffix >> (64 - 5 * suffix_length);
+
+        static constexpr bool matches( uint64_t value ) {
+            const uint32_t length = detail::name_length( value );
+            if (length <= suffix_length)
+                return false;
+            if (length < 13)
+                return ((value >> (64 - 5 * length)) & detail::low_bits( 5 * suffix_length )) == suffix_bits;
+            // The 13th character only has 4 bits.
+            return (value & 0x0Full) == (suffix_bits & 0x1Full)
+                && ((value >> 4) & detail::low_bits( 5 * (suffix_length - 1) )) == (suffix_bits >> 5);
+        }
+
+        static constexpr bool check( name, name account ) { return matches( account.value ); }
+    };
+
+    static_assert( name_suffix<".jc"_n.value>::matches( "alice.jc"_n.value ), "name_suffix" );
+    static_assert( name_suffix<".jc"_n.value>::matches( "abcdefghij.jc"_n.value ), "name_suffix" );
+    static_assert( !name_suffix<".jc"_n.value>::matches( "alicejc"_n.value ), "name_suffix" );
+    static_assert( !name_suffix<".jc"_n.value>::matches( "alice.jc.x"_n.value ), "name_suffix" );
+    static_assert( !name_suffix<".jc"_n.value>::matches( "jc"_n.value ), "name_suffix" );
+    static_assert( !name_suffix<".jc"_n.value>::matches( 0 ), "name_suffix" );
+
+    enum status : uint8_t {
+        unlisted = 0,
+        allowed  = 1,
+        denied   = 2
+    };
+
+    // Allow and deny lists kept by the token contract, in its own scope. See token::setelig().
+    struct [[eosio::table]] listing {
+        name     account;
+        uint8_t  status;
+
+        uint64_t primary_key()const { return account.value; }
+    };
+
+    typedef eosio::multi_index< "eligibility"_n, listing > listings;
+
+    inline uint8_t get_status( name contract, name account ) {
+        listings lst( contract, contract.value );
+        auto it = lst.find( account.value );
+        return it == lst.end() ? unlisted : it->status;
+    }
+
+    // Accounts explicitly allowed by the token contract.
+    struct allowlisted {
+        static bool check( name contract, name account ) { return get_status( contract, account ) == allowed; }
+    };
+
+    // Every account that has not been explicitly denied by the token contract.
+    struct not_denylisted {
+        static bool check( name contract, name account ) { return get_status( contract, account ) != denied; }
+    };
+
+    // Accounts listed by an external KYC registry contract: eligible if "Table" of "Registry", in
+    //   the registry's own scope, has a row whose primary key is the account name.
+    template <name::raw Registry, name::raw Table>
+    struct kyc_registry {
+        struct entry {
+            name account;
+
+            uint64_t primary_key()const { return account.value; }
+        };
+
+        static bool check( name, name account ) {
+            eosio::multi_index< Table, entry > registry( name{Registry}, name{Registry}.value );
+            return registry.find( account.value ) != registry.end();
+        }
+    };
+
+    // The combinators are constexpr over constexpr policies, so that combinations of name_suffix are
+    //   checked below; those of the table policies are checked by native/tools/scenario_checks.cpp.
+    template <typename... Policies>
+    struct all_of {
+        static constexpr bool check( name contract, name account ) { return (Policies::check( contract, account ) && ...); }
+    };
+
+    template <typename... Policies>
+    struct any_of {
+        static constexpr bool check( name contract, name account ) { return (Policies::check( contract, account ) || ...); }
+    };
+
+    template <typename Policy>
+    struct not_ {
+        static constexpr bool check( name contract, name account ) { return !Policy::check( contract, account ); }
+    };
+
+    namespace detail {
+        typedef name_suffix<".jc"_n.value>  jc;
+        typedef name_suffix<".b"_n.value>   b;
+    }
+
+    static_assert( all_of< detail::jc, not_<detail::b> >::check( name{}, "alice.jc"_n ), "all_of" );
+    static_assert( !all_of< detail::jc, detail::b >::check( name{}, "alice.jc"_n ), "all_of" );
+    static_assert( all_of<>::check( name{}, "alice"_n ), "all_of" );
+    static_assert( any_of< detail::jc, detail::b >::check( name{}, "alice.b"_n ), "any_of" );
+    static_assert( !any_of< detail::jc, detail::b >::check( name{}, "alice"_n ), "any_of" );
+    static_assert( !any_of<>::check( name{}, "alice"_n ), "any_of" );
+    static_assert( not_< not_<detail::jc> >::check( name{}, "alice.jc"_n ), "not_" );
+    static_assert( !not_<detail::jc>::check( name{}, "alice.jc"_n ), "not_" );
+
+}} /// namespace eosio::eligibility
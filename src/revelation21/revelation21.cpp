@@ -13,6 +13,9 @@ void token::create(name issuer, asset maximum_supply) {
     eosio_assert( sym.is_valid(), "invalid symbol name" );
     eosio_assert( maximum_supply.is_valid(), "invalid supply");
     eosio_assert( maximum_supply.amount > 0, "max-supply must be positive");
+    eosio_assert( sym.precision() <= ubi_config::max_precision, "precision is too large" );
+    // The largest claim must fit in an asset.
+    eosio_assert( max_past_claim_days + claim_days <= asset::max_amount / get_precision_multiplier(sym), "precision is too large for the UBI schedule" );
 
     stats statstable( _self, sym.code().raw() );
     auto existing = statstable.find( sym.code().raw() );
@@ -23,6 +26,8 @@ void token::create(name issuer, asset maximum_supply) {
         s.max_supply    = maximum_supply;
         s.issuer        = issuer;
     });
+
+    renew_shards( sym, maximum_supply.amount );
 }
 
 // issue() need not be invoked for our UBI token. It doesn't seem to make any sense.
@@ -45,13 +50,32 @@ void token::issue( name to, asset quantity, string memo ) {
     eosio_assert( quantity.amount > 0, "must issue positive quantity" );
 
     eosio_assert( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
-    eosio_assert( quantity.amount <= st.max_supply.amount - st.supply.amount, "quantity exceeds available supply");
+
+    // Only the part of max_supply that is not minted by or allowed to the supply shards is available.
+    //   Whatever is missing is taken back from the shard allowances.
+    supply_shards shards( _self, sym.code().raw() );
+    int64_t available_amount = st.max_supply.amount - st.supply.amount;
+    for (const auto& shard : shards)
+        available_amount -= shard.minted.amount + shard.allowance.amount;
+    for (auto it = shards.begin(); it != shards.end() && available_amount < quantity.amount; ++it) {
+        const int64_t taken = std::min( quantity.amount - available_amount, it->allowance.amount );
+        if (taken > 0) {
+            shards.modify( it, same_payer, [&]( auto& s ) {
+                s.allowance.amount -= taken;
+            });
+            available_amount += taken;
+        }
+    }
+    eosio_assert( quantity.amount <= available_amount, "quantity exceeds available supply");
 
     statstable.modify( st, same_payer, [&]( auto& s ) {
         s.supply += quantity;
     });
 
-    add_balance( st.issuer, quantity, st.issuer );
+    daily_metrics metrics;
+    if (add_balance( st.issuer, quantity, st.issuer, metrics ))
+        track_claim_days( statstable, st, 1, get_first_claim_day() );
+    record_metrics( st, metrics );
 
     if( to != st.issuer ) {
         SEND_INLINE_ACTION( *this, transfer, { {st.issuer, "active"_n} },
@@ -80,7 +104,21 @@ void token::retire( asset quantity, string memo ) {
 
     eosio_assert( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
 
+    // The stat row lags the claims minted by the supply shards since the last compact(): move them into it
+    //   first, so that it never goes below zero. The shards keep their allowances and aggregates.
+    supply_shards shards( _self, sym.code().raw() );
+    asset minted{0, st.supply.symbol};
+    for (auto it = shards.begin(); it != shards.end(); ++it) {
+        if (it->minted.amount != 0) {
+            minted += it->minted;
+            shards.modify( it, same_payer, [&]( auto& s ) {
+                s.minted.set_amount( 0 );
+            });
+        }
+    }
+
     statstable.modify( st, same_payer, [&]( auto& s ) {
+        s.supply += minted;
         s.supply -= quantity;
     });
 
@@ -96,14 +134,16 @@ void token::transfer( name from, name to, asset quantity, string memo) {
     // Hopefully, wallets won't be confused by this.
     //eosio_assert( from != to, "cannot transfer to self" );
 
-    require_auth( from );
+    // UBI claim memo logs (see log_claim()) are transfers to self that are authorized by the contract.
+    if (from != to || !has_auth( _self ))
+        require_auth( from );
     eosio_assert( is_account( to ), "to account does not exist" );
     auto sym = quantity.symbol.code();
     stats statstable( _self, sym.raw() );
     const auto& st = statstable.get( sym.raw() );
 
-    require_recipient( from );
-    require_recipient( to );
+    notify( st, from, false );
+    notify( st, to, true );
 
     eosio_assert( quantity.is_valid(), "invalid quantity" );
     eosio_assert( quantity.amount > 0, "must transfer positive quantity" );
@@ -116,18 +156,83 @@ void token::transfer( name from, name to, asset quantity, string memo) {
 
     auto payer = has_auth( to ) ? to : from;
 
+    accounts from_acnts( _self, from.value );
+    const auto& from_acnt = from_acnts.get( sym.raw(), "no balance object found" );
+
+    daily_metrics metrics;
+    metrics.transfers = 1;
+    metrics.transfer_volume = quantity.amount;
+
     // Check for an UBI claim.
-    try_ubi_claim( from, quantity.symbol, payer, statstable, st );
+    try_ubi_claim( from, from_acnts, from_acnt, st.supply.symbol, from, metrics );
         
     // Do the transfer.
-    sub_balance( from, quantity );
-    add_balance( to, quantity, payer );
+    sub_balance( from, from_acnts, from_acnt, quantity );
+    if (add_balance( to, quantity, payer, metrics ))
+        track_claim_days( to, st.supply.symbol, 1, get_first_claim_day() );
+    record_metrics( st, metrics );
+}
+
+void token::transfermany( name from, const std::vector<payment>& payments ) {
+    require_auth( from );
+    eosio_assert( !payments.empty(), "no payments to transfer" );
+
+    const symbol& sym = payments.front().quantity.symbol;
+    stats statstable( _self, sym.code().raw() );
+    const auto& st = statstable.get( sym.code().raw() );
+    eosio_assert( sym == st.supply.symbol, "symbol precision mismatch" );
+
+    notify( st, from, false );
+
+    asset total = asset{0, sym};
+    for (const auto& p : payments) {
+        eosio_assert( is_account( p.to ), "to account does not exist" );
+        eosio_assert( p.quantity.is_valid(), "invalid quantity" );
+        eosio_assert( p.quantity.amount > 0, "must transfer positive quantity" );
+        eosio_assert( p.quantity.symbol == sym, "symbol precision mismatch" );
+        eosio_assert( p.memo.size() <= 256, "memo has more than 256 bytes" );
+
+        notify( st, p.to, true );
+
+        // Sending to self is a no-op, as in transfer().
+        if (p.to != from)
+            total += p.quantity;
+    }
+
+    if (total.amount == 0)
+        return;
+
+    accounts from_acnts( _self, from.value );
+    const auto& from_acnt = from_acnts.get( sym.code().raw(), "no balance object found" );
+
+    daily_metrics metrics;
+    metrics.transfer_volume = total.amount;
+
+    // Check for an UBI claim, once for the whole batch.
+    try_ubi_claim( from, from_acnts, from_acnt, sym, from, metrics );
+
+    // Do the transfers.
+    sub_balance( from, from_acnts, from_acnt, total );
+    claim_day_changes changes;
+    for (const auto& p : payments) {
+        if (p.to != from) {
+            if (add_balance( p.to, p.quantity, has_auth( p.to ) ? p.to : from, metrics ))
+                changes.add( p.to, 1, get_first_claim_day() );
+            ++metrics.transfers;
+        }
+    }
+    track_claim_days( sym.code(), changes );
+    record_metrics( st, metrics );
 }
 
 void token::sub_balance( name owner, asset value ) {
     accounts from_acnts( _self, owner.value );
 
     const auto& from = from_acnts.get( value.symbol.code().raw(), "no balance object found" );
+    sub_balance( owner, from_acnts, from, value );
+}
+
+void token::sub_balance( name owner, accounts& from_acnts, const account& from, asset value ) {
     eosio_assert( from.balance.amount >= value.amount, "overdrawn balance" );
 
     from_acnts.modify( from, owner, [&]( auto& a ) {
@@ -135,19 +240,123 @@ void token::sub_balance( name owner, asset value ) {
     });
 }
 
-void token::add_balance( name owner, asset value, name ram_payer ) {
+bool token::add_balance( name owner, asset value, name ram_payer, daily_metrics& metrics ) {
     accounts to_acnts( _self, owner.value );
     auto to = to_acnts.find( value.symbol.code().raw() );
     if( to == to_acnts.end() ) {
+        ++metrics.new_holders;
+        const bool ubi = can_claim_UBI(owner);
         to_acnts.emplace( ram_payer, [&]( auto& a ){
             a.balance = value;
+            if (ubi)
+                a.last_claim_day.emplace( get_first_claim_day() );
         });
-        create_extra_record( owner, ram_payer, value.symbol.code().raw() );
+        if (ubi)
+            index_claim_day( owner, value.symbol.code(), get_first_claim_day(), ram_payer );
+        return ubi;
     } else {
         to_acnts.modify( to, same_payer, [&]( auto& a ) {
             a.balance += value;
         });
+        return false;
+    }
+}
+
+void token::track_claim_days( stats& statstable, const currency_stats& st, int64_t accounts_delta, int64_t claim_day_delta ) {
+    statstable.modify( st, same_payer, [&]( auto& s ) {
+        count_claim_days( s, accounts_delta, claim_day_delta );
+    });
+}
+
+// Same as above, in the supply shard of "owner" rather than in the stat row.
+void token::track_claim_days( name owner, const symbol& sym, int64_t accounts_delta, int64_t claim_day_delta ) {
+    supply_shards shards( _self, sym.code().raw() );
+    shards.modify( get_shard( shards, shard_of( owner ) ), same_payer, [&]( auto& s ) {
+        s.ubi_accounts += accounts_delta;
+        s.claim_day_sum += claim_day_delta;
+    });
+}
+
+// Same as above, for the changes of a batch, with one write per shard.
+void token::track_claim_days( const symbol_code& sym, const claim_day_changes& changes ) {
+    if (changes.shards.empty())
+        return;
+    supply_shards shards( _self, sym.raw() );
+    for (const auto& change : changes.shards) {
+        shards.modify( get_shard( shards, change.id ), same_payer, [&]( auto& s ) {
+            s.ubi_accounts  += change.accounts;
+            s.claim_day_sum += change.days;
+        });
+    }
+}
+
+const token::supply_shard& token::get_shard( supply_shards& shards, uint64_t id ) {
+    // Creating it here would leave it without an allowance, and every claim from it would pay nothing.
+    return shards.get( id, "the supply shards of this token are not set up: run compact() after the upgrade" );
+}
+
+void token::compact( const symbol_code& sym ) {
+    require_auth( _self );
+
+    stats statstable( _self, sym.raw() );
+    const auto& st = statstable.get( sym.raw(), "symbol does not exist" );
+    const currency_stats folded = fold_shards( _self, st );
+
+    // The filter of the accounts still in "notifyprefs", without the bits of those that left it.
+    notify_prefs prefs( _self, sym.raw() );
+    std::vector<name> listed;
+    for (const auto& p : prefs)
+        listed.push_back( p.account );
+    std::vector<uint8_t> filter( listed.empty() ? 0 : notify_filter_bytes( listed.size() ), 0 );
+    for (name account : listed) {
+        for (int i = 0; i < 2; ++i) {
+            const uint32_t bit = notify_filter_bit( account, i, filter.size() );
+            filter[bit / 8] |= uint8_t( 1 << (bit % 8) );
+        }
+    }
+
+    statstable.modify( st, same_payer, [&]( auto& s ) {
+        s.supply = folded.supply;
+        s.ubi_accounts.emplace( folded.ubi_accounts.value_or() );
+        s.claim_day_sum.emplace( folded.claim_day_sum.value_or() );
+        // Without any account left, the row goes back to its size before the first setnotify().
+        if (listed.empty()) {
+            s.notify_filter.reset();
+        } else {
+            s.metrics_days.emplace( s.metrics_days.value_or() );
+            s.notify_filter.emplace( std::move( filter ) );
+        }
+    });
+
+    renew_shards( folded.supply.symbol, folded.max_supply.amount - folded.supply.amount );
+}
+
+// Shares "headroom" out as the allowances of the supply shards of a token, and clears what they have
+//   minted and counted, which must have been folded into the stat row already.
+void token::renew_shards( const symbol& sym, int64_t headroom ) {
+    supply_shards shards( _self, sym.code().raw() );
+    for (uint64_t id = 0; id < supply_shard_count; ++id) {
+        const asset allowance{ headroom / supply_shard_count + (id == 0 ? headroom % supply_shard_count : 0), sym };
+        auto it = shards.find( id );
+        if (it == shards.end()) {
+            shards.emplace( _self, [&]( auto& s ) {
+                s.id        = id;
+                s.minted    = asset{0, sym};
+                s.allowance = allowance;
+            });
+        } else {
+            shards.modify( it, same_payer, [&]( auto& s ) {
+                s.minted        = asset{0, sym};
+                s.allowance     = allowance;
+                s.ubi_accounts  = 0;
+                s.claim_day_sum = 0;
+            });
+        }
     }
+
+    // Shards left over from a schedule with more of them.
+    for (auto it = shards.lower_bound( supply_shard_count ); it != shards.end(); )
+        it = shards.erase( it );
 }
 
 // Opening an account will immediately reward the user with UBI.
@@ -160,18 +369,132 @@ void token::open( name owner, const symbol& symbol, name ram_payer ){
     const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
     eosio_assert( st.supply.symbol == symbol, "symbol precision mismatch" );
 
+    daily_metrics metrics;
     accounts acnts( _self, owner.value );
     auto it = acnts.find( sym_code_raw );
+    bool opened = false;
     if ( it == acnts.end() ) {
-        acnts.emplace( ram_payer, [&]( auto& a ){
+        ++metrics.new_holders;
+        const bool ubi = can_claim_UBI(owner);
+        it = acnts.emplace( ram_payer, [&]( auto& a ){
             a.balance = asset{0, symbol};
+            if (ubi)
+                a.last_claim_day.emplace( get_first_claim_day() );
         });
-
-        create_extra_record( owner, ram_payer, sym_code_raw );
+        if (ubi) {
+            index_claim_day( owner, symbol.code(), get_first_claim_day(), ram_payer );
+            // The contract does not claim, so its row is counted here rather than by try_ubi_claim().
+            if (owner == _self)
+                track_claim_days( owner, symbol, 1, get_first_claim_day() );
+        }
+        opened = ubi;
     }
 
     // Perform a regular UBI check as part of any open() call.
-    try_ubi_claim( owner, symbol, ram_payer, statstable, st );
+    try_ubi_claim( owner, acnts, *it, symbol, ram_payer, metrics, opened );
+    record_metrics( st, metrics );
+}
+
+void token::openmany( name sponsor, const symbol& symbol, uint64_t wave, const std::vector<name>& owners ) {
+    require_auth( sponsor );
+
+    auto sym_code_raw = symbol.code().raw();
+
+    stats statstable( _self, sym_code_raw );
+    const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
+    eosio_assert( st.supply.symbol == symbol, "symbol precision mismatch" );
+
+    onboardings obs( _self, sponsor.value );
+    auto ob = obs.find( sym_code_raw );
+    onboarding progress{ symbol.code(), wave, name(), 0 };
+    if (ob != obs.end() && ob->wave == wave)
+        progress = *ob;
+
+    // The claims are minted from the shards of the owners, which are updated in memory as the batch goes,
+    //   so that their allowances still cap the claims, and written once each at the end.
+    supply_shards shards( _self, sym_code_raw );
+    std::vector<supply_shard> touched;
+    touched.reserve( supply_shard_count );
+    auto shard_for = [&]( name owner ) -> supply_shard& {
+        const uint64_t id = shard_of( owner );
+        for (auto& shard : touched) {
+            if (shard.id == id)
+                return shard;
+        }
+        touched.push_back( get_shard( shards, id ) );
+        return touched.back();
+    };
+
+    const time_type first_claim_day = get_first_claim_day();
+    const time_type today = get_today();
+    daily_metrics metrics;
+
+    name previous;
+    for (const name& owner : owners) {
+        // An owner out of order would be taken for one done by a previous chunk, and silently skipped.
+        eosio_assert( owner.value > previous.value, "owners must be sorted by ascending name" );
+        previous = owner;
+        // Already opened by a previous chunk of this wave.
+        if (owner.value <= progress.cursor.value)
+            continue;
+        progress.cursor = owner;
+
+        accounts acnts( _self, owner.value );
+        if (acnts.find( sym_code_raw ) != acnts.end())
+            continue;
+
+        // The same row that open() followed by its first claim would leave.
+        const bool ubi = can_claim_UBI(owner);
+        claim_result claim{ asset{0, symbol}, first_claim_day, 0 };
+        if (ubi) {
+            supply_shard& shard = shard_for( owner );
+            if (owner != _self)
+                claim = compute_claim( first_claim_day, today, symbol, shard.allowance.amount );
+            if (claim.quantity.amount > 0) {
+                shard.minted    += claim.quantity;
+                shard.allowance -= claim.quantity;
+            }
+            ++shard.ubi_accounts;
+            shard.claim_day_sum += claim.quantity.amount > 0 ? claim.next_claim_day : first_claim_day;
+        }
+        const bool paid = claim.quantity.amount > 0;
+        const time_type last_claim_day = paid ? claim.next_claim_day : first_claim_day;
+
+        acnts.emplace( sponsor, [&]( auto& a ){
+            a.balance = paid ? claim.quantity : asset{0, symbol};
+            if (ubi)
+                a.last_claim_day.emplace( last_claim_day );
+        });
+        if (ubi)
+            index_claim_day( owner, symbol.code(), last_claim_day, sponsor );
+        ++progress.opened;
+        ++metrics.new_holders;
+        if (paid) {
+            ++metrics.claims;
+            metrics.minted += claim.quantity.amount;
+            metrics.lost_days += claim.lost_days;
+        }
+
+        if (paid && log_ubi_claims)
+            log_claim( owner, claim.quantity, claim.next_claim_day, claim.lost_days );
+    }
+
+    for (const auto& shard : touched) {
+        shards.modify( shards.get( shard.id ), same_payer, [&]( auto& s ) {
+            s = shard;
+        });
+    }
+
+    if (ob == obs.end()) {
+        obs.emplace( sponsor, [&]( auto& o ) {
+            o = progress;
+        });
+    } else {
+        obs.modify( ob, same_payer, [&]( auto& o ) {
+            o = progress;
+        });
+    }
+    record_metrics( st, metrics );
 }
 
 void token::close( name owner, const symbol& symbol ) {
@@ -181,41 +504,384 @@ void token::close( name owner, const symbol& symbol ) {
     eosio_assert( it != acnts.end(), "Balance row already deleted or never existed. Action won't have any effect." );
     eosio_assert( it->balance.amount == 0, "Cannot close because the balance is not zero." );
 
-    // delete extras table row too
-    if (can_claim_UBI(owner)) {
+    // users cannot close their token records if they have already received income for the
+    // current day. if this is not stopped, users can print infinite money by repeatedly closing and reopening.
+    if (it->last_claim_day.has_value()) {
+        eosio_assert( it->last_claim_day.value() < get_today(), "Cannot close() yet: income was already claimed for today." );
+        track_claim_days( owner, it->balance.symbol, -1, -int64_t(it->last_claim_day.value()) );
+        index_claim_day( owner, symbol.code(), 0, same_payer );
+    } else if (can_claim_UBI(owner)) {
+        // delete the not yet migrated extras table row too
         extras xtrs( _self, owner.value );
         auto itx = xtrs.find( symbol.code().raw() );
-        // users cannot close their token records if they have already received income for the
-        // current day. if this is not stopped, users can print infinite money by repeatedly closing and reopening.
-        eosio_assert( itx->last_claim_day < get_today(), "Cannot close() yet: income was already claimed for today." );
-        xtrs.erase( itx );
+        if (itx != xtrs.end()) {
+            eosio_assert( itx->last_claim_day < get_today(), "Cannot close() yet: income was already claimed for today." );
+            xtrs.erase( itx );
+        }
     }
 
     acnts.erase( it );
+
+    // close() does not need the stat row otherwise, so it is only read for the metrics, when the token
+    //   keeps them: the metrics table has rows exactly then (see setmetrics()), and probing it does not
+    //   read a row when it is empty.
+    metrics_buckets buckets( _self, symbol.code().raw() );
+    if (buckets.begin() != buckets.end()) {
+        stats statstable( _self, symbol.code().raw() );
+        auto st = statstable.find( symbol.code().raw() );
+        if (st != statstable.end()) {
+            daily_metrics metrics;
+            metrics.closed_holders = 1;
+            record_metrics( *st, metrics );
+        }
+    }
+}
+
+void token::migrate( const symbol_code& sym, const std::vector<name>& owners ) {
+    require_auth( _self );
+
+    migration_singleton migration( _self, sym.raw() );
+    migration_state state = migration.get_or_default();
+    claim_day_changes changes;
+
+    name previous;
+    for (const name& owner : owners) {
+        eosio_assert( owner.value > previous.value, "owners must be sorted by ascending name" );
+        previous = owner;
+        // Already migrated by a previous chunk.
+        if (owner.value <= state.cursor.value)
+            continue;
+        state.cursor = owner;
+
+        if (migrate_owner( owner, sym, changes ))
+            ++state.migrated;
+    }
+
+    track_claim_days( sym, changes );
+    migration.set( state, _self );
+}
+
+// Moves the claim day of "owner" from its extras row into its accounts row. Returns false if it has no
+//   extras row.
+bool token::migrate_owner( name owner, const symbol_code& sym, claim_day_changes& changes ) {
+    extras xtrs( _self, owner.value );
+    auto itx = xtrs.find( sym.raw() );
+    if (itx == xtrs.end())
+        return false;
+
+    accounts acnts( _self, owner.value );
+    auto it = acnts.find( sym.raw() );
+    // An extras row without a balance row is an orphan and is simply dropped. The balance row grows by
+    //   the claim day, which only the contract can pay for here: its owner did not authorize the action.
+    if (it != acnts.end() && !it->last_claim_day.has_value()) {
+        acnts.modify( it, _self, [&]( auto& a ) {
+            a.last_claim_day.emplace( itx->last_claim_day );
+        });
+        changes.add( owner, 1, itx->last_claim_day );
+        index_claim_day( owner, sym, itx->last_claim_day, _self );
+    }
+    xtrs.erase( itx );
+    return true;
+}
+
+void token::maintain( const symbol_code& sym, uint8_t pass, bool restart, const std::vector<name>& owners, uint32_t max_rows ) {
+    require_auth( _self );
+    eosio_assert( pass < maintenance_passes, "invalid maintenance pass" );
+
+    static const maintenance_step steps[maintenance_passes] = {
+        &token::cleanup_step,
+        &token::audit_step,
+        &token::migrate_step,
+        &token::index_step
+    };
+
+    maintenance_singleton maintenance( _self, sym.raw() );
+    maintenance_state state = maintenance.get_or_default();
+    if (restart || state.pass != pass) {
+        state = maintenance_state();
+        state.pass = pass;
+    }
+
+    claim_day_changes changes;
+    uint32_t rows = 0;
+    name previous;
+    for (const name& owner : owners) {
+        eosio_assert( owner.value > previous.value, "owners must be sorted by ascending name" );
+        previous = owner;
+        // Already done by a previous chunk.
+        if (owner.value <= state.cursor.value)
+            continue;
+        // Left for the next call.
+        if (rows >= max_rows)
+            break;
+        rows += (this->*steps[pass])( owner, sym, state, changes );
+        state.cursor = owner;
+        ++state.owners;
+    }
+
+    stats statstable( _self, sym.raw() );
+    const auto& st = statstable.get( sym.raw(), "symbol does not exist" );
+    track_claim_days( sym, changes );
+    maintenance.set( state, _self );
+
+    print( "{\"pass\":", uint32_t(state.pass), ",\"cursor\":\"", state.cursor, "\",\"owners\":", state.owners,
+           ",\"changed\":", state.changed );
+    if (pass == audit_pass) {
+        const currency_stats folded = fold_shards( _self, st );
+        print( ",\"balance_sum\":", state.balance_sum, ",\"supply\":", folded.supply.amount,
+               ",\"ubi_accounts\":", state.ubi_accounts, ",\"stat_ubi_accounts\":", folded.ubi_accounts.value_or(),
+               ",\"claim_day_sum\":", state.claim_day_sum, ",\"stat_claim_day_sum\":", folded.claim_day_sum.value_or() );
+    }
+    print( "}" );
 }
 
-void token::create_extra_record( name owner, name ram_payer, uint64_t sym_code_raw ) {
-    if (!can_claim_UBI(owner)) return;
+uint32_t token::cleanup_step( name owner, const symbol_code& sym, maintenance_state& state, claim_day_changes& changes ) {
+    accounts acnts( _self, owner.value );
+    auto it = acnts.find( sym.raw() );
     extras xtrs( _self, owner.value );
-    xtrs.emplace( ram_payer, [&]( auto& a ){
-        a.symbol_code_raw = sym_code_raw;
-        a.last_claim_day = 18047; // 30 de mayo
-        // 18016 - 29 de abril
-        // 18017 - 30 de abril
-        // 18018 - 1 de mayo
-        // 18019 - 2 de mayo
-        // 18047 - 30 de mayo
-        // if we are in an everything-goes, free EOSIO public chain, then
-        //   open() needs to add a two-day grace period for any UBI claims
-        //   to mitigate money printing by repeated account creation/destruction.
-        if (unbounded_UBI_account_creation) {
-            a.last_claim_day += 2;
+    auto itx = xtrs.find( sym.raw() );
+    uint32_t rows = 2;
+
+    // An extras row is orphaned without a balance row, and stale once the balance row has its own claim day.
+    if (itx != xtrs.end() && (it == acnts.end() || it->last_claim_day.has_value())) {
+        xtrs.erase( itx );
+        itx = xtrs.end();
+        ++state.changed;
+        ++rows;
+    }
+
+    // A zero balance that carries no claim state is what close() would leave behind. Accounts that can
+    //   claim UBI keep their row, since closing it is restricted to protect the claim day.
+    if (it != acnts.end() && it->balance.amount == 0 && !it->last_claim_day.has_value() && itx == xtrs.end()
+        && !can_claim_UBI( owner )) {
+        acnts.erase( it );
+        ++state.changed;
+        ++rows;
+    }
+    return rows;
+}
+
+uint32_t token::audit_step( name owner, const symbol_code& sym, maintenance_state& state, claim_day_changes& changes ) {
+    accounts acnts( _self, owner.value );
+    auto it = acnts.find( sym.raw() );
+    if (it != acnts.end()) {
+        state.balance_sum += it->balance.amount;
+        if (it->last_claim_day.has_value()) {
+            ++state.ubi_accounts;
+            state.claim_day_sum += it->last_claim_day.value();
+        }
+    }
+    return 1;
+}
+
+uint32_t token::migrate_step( name owner, const symbol_code& sym, maintenance_state& state, claim_day_changes& changes ) {
+    if (!migrate_owner( owner, sym, changes ))
+        return 1;
+    ++state.changed;
+    return 3;
+}
+
+uint32_t token::index_step( name owner, const symbol_code& sym, maintenance_state& state, claim_day_changes& changes ) {
+    accounts acnts( _self, owner.value );
+    auto it = acnts.find( sym.raw() );
+    const time_type claim_day = it != acnts.end() && it->last_claim_day.has_value() ? it->last_claim_day.value() : 0;
+    if (!index_claim_day( owner, sym, claim_day, _self ))
+        return 2;
+    ++state.changed;
+    return 3;
+}
+
+bool token::index_claim_day( name owner, const symbol_code& sym, time_type claim_day, name payer ) {
+    if (!index_claim_days)
+        return false;
+
+    claim_index index( _self, sym.raw() );
+    auto it = index.find( owner.value );
+    if (claim_day == 0) {
+        if (it == index.end())
+            return false;
+        index.erase( it );
+    } else if (it == index.end()) {
+        index.emplace( payer, [&]( auto& e ) {
+            e.owner = owner;
+            e.last_claim_day = claim_day;
+        });
+    } else if (it->last_claim_day != claim_day) {
+        index.modify( it, same_payer, [&]( auto& e ) {
+            e.last_claim_day = claim_day;
+        });
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void token::setmetrics( const symbol_code& sym, time_type days ) {
+    require_auth( _self );
+    eosio_assert( days <= max_metrics_days, "too many metrics days" );
+
+    stats statstable( _self, sym.raw() );
+    const auto& st = statstable.get( sym.raw(), "symbol does not exist" );
+
+    // Rows kept for another number of days are in the wrong slots for the new one.
+    metrics_buckets buckets( _self, sym.raw() );
+    for (auto it = buckets.begin(); it != buckets.end(); )
+        it = buckets.erase( it );
+
+    // The table is left with a row exactly when metrics are kept, which is all close() checks.
+    if (days > 0) {
+        buckets.emplace( _self, [&]( auto& b ) {
+            b.slot = get_today() % days;
+            b.counters.day = get_today();
+        });
+    }
+
+    statstable.modify( st, same_payer, [&]( auto& s ) {
+        // The extensions before metrics_days must be present for it to be written.
+        count_claim_days( s, 0, 0 );
+        s.metrics_days.emplace( days );
+    });
+}
+
+void token::record_metrics( const currency_stats& st, const daily_metrics& metrics ) {
+    const time_type days = st.metrics_days.value_or();
+    if (days == 0 || metrics.empty())
+        return;
+
+    const time_type today = get_today();
+    auto add = [&]( metrics_bucket& b ) {
+        if (b.counters.day != today) {
+            b.counters = daily_metrics();
+            b.counters.day = today;
+        }
+        b.counters.transfers       += metrics.transfers;
+        b.counters.transfer_volume += metrics.transfer_volume;
+        b.counters.claims          += metrics.claims;
+        b.counters.minted          += metrics.minted;
+        b.counters.lost_days       += metrics.lost_days;
+        b.counters.new_holders     += metrics.new_holders;
+        b.counters.closed_holders  += metrics.closed_holders;
+    };
+
+    metrics_buckets buckets( _self, st.supply.symbol.code().raw() );
+    auto it = buckets.find( today % days );
+    if (it == buckets.end()) {
+        buckets.emplace( _self, [&]( auto& b ) {
+            b.slot = today % days;
+            add( b );
+        });
+    } else {
+        buckets.modify( it, same_payer, add );
+    }
+}
+
+void token::setelig( name account, uint8_t status ) {
+    require_auth( _self );
+    eosio_assert( status <= eligibility::denied, "invalid eligibility status" );
+
+    eligibility::listings lst( _self, _self.value );
+    auto it = lst.find( account.value );
+    if (status == eligibility::unlisted) {
+        eosio_assert( it != lst.end(), "account is not listed" );
+        lst.erase( it );
+    } else if (it == lst.end()) {
+        lst.emplace( _self, [&]( auto& l ) {
+            l.account = account;
+            l.status = status;
+        });
+    } else {
+        lst.modify( it, same_payer, [&]( auto& l ) {
+            l.status = status;
+        });
+    }
+}
+
+void token::setnotify( name account, const symbol_code& sym, uint8_t mode ) {
+    require_auth( account );
+    eosio_assert( mode < notify_modes, "invalid notification mode" );
+
+    stats statstable( _self, sym.raw() );
+    const auto& st = statstable.get( sym.raw(), "symbol does not exist" );
+
+    notify_prefs prefs( _self, sym.raw() );
+    auto it = prefs.find( account.value );
+    if (mode == notify_all) {
+        // The bits of the account are left in the filter, since they may be shared, until compact()
+        //   rebuilds it. Until then, a filter hit without a row only costs the read of the row.
+        eosio_assert( it != prefs.end(), "account is already notified of every transfer" );
+        prefs.erase( it );
+        return;
+    }
+
+    if (it == prefs.end()) {
+        prefs.emplace( account, [&]( auto& p ) {
+            p.account = account;
+            p.mode = mode;
+        });
+    } else {
+        prefs.modify( it, same_payer, [&]( auto& p ) {
+            p.mode = mode;
+        });
+    }
+
+    statstable.modify( st, same_payer, [&]( auto& s ) {
+        // The extensions before notify_filter must be present for it to be written.
+        count_claim_days( s, 0, 0 );
+        s.metrics_days.emplace( s.metrics_days.value_or() );
+        if (!s.notify_filter.has_value())
+            s.notify_filter.emplace( notify_filter_bytes( 1 ), 0 );
+        std::vector<uint8_t>& filter = *s.notify_filter;
+        for (int i = 0; i < 2; ++i) {
+            const uint32_t bit = notify_filter_bit( account, i, filter.size() );
+            filter[bit / 8] |= uint8_t( 1 << (bit % 8) );
+        }
+    });
+}
+
+void token::notify( const currency_stats& st, name account, bool incoming ) {
+    if (st.notify_filter.has_value()) {
+        const std::vector<uint8_t>& filter = *st.notify_filter;
+        bool listed = true;
+        for (int i = 0; i < 2; ++i) {
+            const uint32_t bit = notify_filter_bit( account, i, filter.size() );
+            listed = listed && (filter[bit / 8] & (1 << (bit % 8)));
+        }
+        if (listed) {
+            notify_prefs prefs( _self, st.supply.symbol.code().raw() );
+            auto it = prefs.find( account.value );
+            if (it != prefs.end() && (!incoming || it->mode == notify_none))
+                return;
         }
+    }
+    require_recipient( account );
+}
+
+// Moves the claim day of an UBI account that has not been migrated yet from its "extras" row into its
+//   "accounts" row. Accounts that were opened before they were authorized to claim UBI have no extras
+//   row, and start claiming as a new row does (see get_first_claim_day()).
+// The row grows by the claim day, so it is billed to "payer" rather than to whoever paid for it, who may
+//   not have authorized the action (e.g. the sender of the tokens it first received). So is the
+//   "claimindex" row the account gets.
+token::time_type token::migrate_extra_record( name owner, accounts& acnts, const account& acnt, name payer ) {
+    time_type last_claim_day = get_first_claim_day();
+
+    extras xtrs( _self, owner.value );
+    auto itx = xtrs.find( acnt.balance.symbol.code().raw() );
+    if (itx != xtrs.end()) {
+        last_claim_day = itx->last_claim_day;
+        xtrs.erase( itx );
+    }
+
+    acnts.modify( acnt, payer, [&]( auto& a ) {
+        a.last_claim_day.emplace( last_claim_day );
     });
+    index_claim_day( owner, acnt.balance.symbol.code(), last_claim_day, payer );
+    return last_claim_day;
 }
 
 // This was moved from transfer() to keep it readable.
-void token::try_ubi_claim( name from, const symbol& sym, name payer, stats& statstable, const currency_stats& st ) {
+void token::try_ubi_claim( name from, accounts& from_acnts, const account& from_acnt, const symbol& sym, name payer,
+                           daily_metrics& metrics, bool opened ) {
     // Check if the "from" account is authorized to receive it.
     if (! can_claim_UBI( from ))
         return;
@@ -224,101 +890,153 @@ void token::try_ubi_claim( name from, const symbol& sym, name payer, stats& stat
     if (from == _self)
         return;
   
-    extras from_xtrs( _self, from.value );
-    const auto& from_extra = from_xtrs.get( sym.code().raw(), "no balance object found" );
+    // A row migrated from the "extras" table, or just opened, starts being counted in the liability
+    //   aggregates here.
+    const bool migrated = !from_acnt.last_claim_day.has_value();
+    const time_type last_claim_day = migrated ?
+        migrate_extra_record( from, from_acnts, from_acnt, payer ) : from_acnt.last_claim_day.value();
+    const bool counted = migrated || opened;
     
+    // Already claimed today: nothing else to read or write.
     const time_type today = get_today();
-  
-    if (from_extra.last_claim_day < today) {
-        
-        // The UBI grants 1 token per day per account. 
-        // Users will automatically issue their own money as a side-effect of giving money to others.
-        
-        // Compute the claim amount relative to days elapsed since the last claim, excluding today's pay.
-        // If you claimed yesterday, this is zero.
-        int64_t claim_amount = today - from_extra.last_claim_day - 1;
-        // The limit for claiming accumulated past income is 360 days/coins. Unclaimed tokens past that
-        //   one year maximum of accumulation are lost.
-        time_type lost_days = 0;
-        if (claim_amount > max_past_claim_days) {
-            lost_days = claim_amount - max_past_claim_days;
-            claim_amount = max_past_claim_days;
-        }
-        // You always claim for the next 30 days, counting today. This is the advance-payment part
-        //   of the UBI claim.
-        claim_amount += claim_days;
-        
-        int64_t precision_multiplier = get_precision_multiplier(sym);
-        asset claim_quantity = asset{claim_amount * precision_multiplier, sym};
-        
-        // Respect the max_supply limit for UBI issuance.
-        int64_t available_amount = st.max_supply.amount - st.supply.amount;
-        if (claim_quantity.amount > available_amount)
-        claim_quantity.set_amount(available_amount);
-        
-        time_type last_claim_day_delta = lost_days + (claim_quantity.amount / precision_multiplier);
-        
-        if (claim_quantity.amount > 0) {
-
-            // 1.8 version fix
-            string memo = claim_memo( from, claim_quantity, from_extra.last_claim_day + last_claim_day_delta, lost_days );
-            PRINT(memo.c_str(),"\n");
-
-            action(
-                permission_level{get_self(), name("active")},
-                get_self(),
-                name("issue"),
-                std::make_tuple(from, claim_quantity, memo)
-            ).send();
-
-            // Finally, move the claim date window proportional to the amount of days of income we claimed
-            //   (and also account for days of income that have been forever lost)
-            from_xtrs.modify( from_extra, from, [&]( auto& a ) {
-                a.last_claim_day += last_claim_day_delta;
-            });
+    if (last_claim_day >= today && !counted)
+        return;
 
-            
-            /*
-            // Log this basic income payment with a fake inline transfer action to self.
-            log_claim( from, claim_quantity, from_extra.last_claim_day + last_claim_day_delta, lost_days );
-            
-            // Update the token total supply.
-            statstable.modify( st, same_payer, [&]( auto& s ) {
-                s.supply += claim_quantity;
-            });
-            
-            // Finally, move the claim date window proportional to the amount of days of income we claimed
-            //   (and also account for days of income that have been forever lost)
-            from_xtrs.modify( from_extra, from, [&]( auto& a ) {
-                a.last_claim_day += last_claim_day_delta;
-            });
-            
-            // Pay the user doing the transfer ("from").
-            add_balance( from, claim_quantity, payer );
-            */
-        }
+    supply_shards shards( _self, sym.code().raw() );
+    const auto& shard = get_shard( shards, shard_of( from ) );
+
+    const claim_result claim = compute_claim( last_claim_day, today, sym, shard.allowance.amount );
+    const bool paid = claim.quantity.amount > 0;
+    if (paid || counted) {
+        // Mint the claim and update the liability aggregates with a single write to the claimant's supply
+        //   shard. The claim is minted right here instead of going through an inline issue() -> transfer()
+        //   chain, so a claim costs no extra actions, and claims of accounts in other shards don't touch
+        //   any row this one writes.
+        shards.modify( shard, same_payer, [&]( auto& s ) {
+            if (paid) {
+                s.minted    += claim.quantity;
+                s.allowance -= claim.quantity;
+            }
+            s.ubi_accounts  += counted ? 1 : 0;
+            s.claim_day_sum += (counted ? last_claim_day : 0) + (paid ? claim.next_claim_day - last_claim_day : 0);
+        });
+    }
+
+    if (paid) {
+        // Pay the user doing the transfer ("from") and move its claim date window.
+        from_acnts.modify( from_acnt, same_payer, [&]( auto& a ) {
+            a.balance += claim.quantity;
+            a.last_claim_day.emplace( claim.next_claim_day );
+        });
+        // A row opened before the "claimindex" table existed gets its index row here, billed like the
+        //   claim day itself.
+        index_claim_day( from, sym.code(), claim.next_claim_day, payer );
+
+        ++metrics.claims;
+        metrics.minted += claim.quantity.amount;
+        metrics.lost_days += claim.lost_days;
+
+        // Log this basic income payment with a fake inline transfer action to self.
+        if (log_ubi_claims)
+            log_claim( from, claim.quantity, claim.next_claim_day, claim.lost_days );
+    }
+}
+
+void token::getaccrued( const std::vector<balance_query>& queries ) {
+    print( "[" );
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const balance_query& q = queries[i];
+        const accrued_balance ab = get_accrued_balance( _self, q.owner, q.sym );
+        if (i > 0)
+            print( "," );
+        print( "{\"owner\":\"", q.owner, "\",\"balance\":\"", ab.balance, "\",\"claimable\":\"", ab.claimable,
+               "\",\"lost_days\":", ab.lost_days, "}" );
+    }
+    print( "]" );
+}
+
+void token::getliability( const symbol_code& sym ) {
+    const ubi_liability l = get_ubi_liability( _self, sym );
+    print( "{\"ubi_accounts\":", l.ubi_accounts, ",\"unclaimed_days\":", l.unclaimed_days, ",\"unclaimed\":\"", l.unclaimed,
+           "\",\"projected_supply\":\"", l.projected_supply, "\"}" );
+}
+
+void token::getdormant( const symbol_code& sym, time_type from_day, time_type to_day, uint32_t limit ) {
+    const std::vector<dormant_account> dormant = get_dormant( _self, sym, from_day, to_day, limit );
+    print( "[" );
+    for (size_t i = 0; i < dormant.size(); ++i) {
+        if (i > 0)
+            print( "," );
+        print( "{\"owner\":\"", dormant[i].owner, "\",\"last_claim_day\":", dormant[i].last_claim_day, "}" );
+    }
+    print( "]" );
+}
+
+void token::getmetrics( const symbol_code& sym ) {
+    const std::vector<daily_metrics> metrics = get_metrics( _self, sym );
+    print( "[" );
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        const daily_metrics& m = metrics[i];
+        if (i > 0)
+            print( "," );
+        print( "{\"day\":", m.day, ",\"transfers\":", m.transfers, ",\"transfer_volume\":", m.transfer_volume,
+               ",\"claims\":", m.claims, ",\"minted\":", m.minted, ",\"lost_days\":", m.lost_days,
+               ",\"new_holders\":", m.new_holders, ",\"closed_holders\":", m.closed_holders, "}" );
     }
+    print( "]" );
+}
+
+void token::ubireceipt( name claimant, asset quantity, time_type next_claim_day, time_type lost_days ) {
+    require_auth( _self );
+    stats statstable( _self, quantity.symbol.code().raw() );
+    notify( statstable.get( quantity.symbol.code().raw() ), claimant, true );
 }
 
+#ifdef CLAIM_MEMO
+
 // This calls a transfer-to-self just to log a memo that explains what the UBI payment was.
-string token::claim_memo( name claimant, asset claim_quantity, time_type next_last_claim_day, time_type lost_days ) {
-    string claim_memo = string("You, ");
-    claim_memo.append(claimant.to_string());
-    claim_memo.append(", carry the seal. Blessed is thee. The blessed may drink daily from the HEART spring; however you must give first, before you receive." );
-    claim_memo.append(" [Next HEART - " );
-    claim_memo.append( days_to_string(next_last_claim_day + 1) );
-    claim_memo.append( "]" );
+// The transfer is authorized by the contract itself, so the claimant does not need to grant
+//   eosio.code to this contract for it to go through.
+void token::log_claim( name claimant, asset claim_quantity, time_type next_last_claim_day, time_type lost_days ) {
+    char buf[max_claim_memo_size];
+    const string memo( buf, claim_memo( buf, claimant, next_last_claim_day ) );
+    PRINT(memo.c_str(),"\n");
+
+    SEND_INLINE_ACTION( *this, transfer, { {get_self(), "active"_n} },
+                        { claimant, claimant, claim_quantity, memo }
+    );
+}
+
+// The memo is put together in a fixed buffer with integer formatting, so that the only string allocated for
+//   it is the transfer() argument. Returns the memo length.
+size_t token::claim_memo( char* buf, name claimant, time_type next_last_claim_day ) {
+    static const char you[] = "You, ";
+    static const char blessing[] = ", carry the seal. Blessed is thee. The blessed may drink daily from the HEART spring; however you must give first, before you receive. [Next HEART - ";
+    // Up to 13 characters of name, and a dd-mm-yyyy date followed by "]".
+    static_assert( sizeof(you) - 1 + 13 + sizeof(blessing) - 1 + 10 + 1 <= max_claim_memo_size, "claim memo buffer is too small" );
 
-    // 1.8 version fix
-    // SEND_INLINE_ACTION( *this, transfer, { {claimant, "active"_n} },
-	// 	      { claimant, claimant, claim_quantity, claim_memo }
-    // );
+    char* p = buf;
+    memcpy( p, you, sizeof(you) - 1 );
+    p += sizeof(you) - 1;
+    p = write_name( p, claimant );
+    memcpy( p, blessing, sizeof(blessing) - 1 );
+    p += sizeof(blessing) - 1;
+    p = write_date( p, next_last_claim_day + 1 );
+    *p++ = ']';
+    return p - buf;
+}
 
-    return claim_memo;
+// Same characters as name::to_string(), without the string.
+char* token::write_name( char* p, name n ) {
+    static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+    uint64_t v = n.value;
+    for (uint8_t i = 0; i < n.length(); ++i, v <<= 5)
+        *p++ = charmap[i < 12 ? v >> 59 : v >> 60];
+    return p;
 }
 
-// Input is days since epoch
-string token::days_to_string( int64_t days ) {
+// Input is days since epoch. Writes the date as dd-mm-yyyy: days are 16-bit, so years have 4 digits.
+char* token::write_date( char* p, int64_t days ) {
     // https://stackoverflow.com/questions/7960318/math-to-convert-seconds-since-1970-into-date-and-vice-versa
     // http://howardhinnant.github.io/date_algorithms.html
     days += 719468;
@@ -330,20 +1048,34 @@ string token::days_to_string( int64_t days ) {
     const unsigned mp = (5*doy + 2)/153;                                   // [0, 11]
     const unsigned d = doy - (153*mp+2)/5 + 1;                             // [1, 31]
     const unsigned m = mp + (mp < 10 ? 3 : -9);                            // [1, 12]
-    
-    string s = std::to_string(d);
-    if (s.length() == 1)
-        s = "0" + s;
-    s.append("-");
-    string ms = std::to_string(m);
-    if (ms.length() == 1)
-        ms = "0" + ms;
-    s.append( ms );
-    s.append("-");
-    s.append( std::to_string(y + (m <= 2)) );
-    return s;
+    const unsigned year = static_cast<unsigned>(y + (m <= 2));
+
+    *p++ = '0' + d / 10;
+    *p++ = '0' + d % 10;
+    *p++ = '-';
+    *p++ = '0' + m / 10;
+    *p++ = '0' + m % 10;
+    *p++ = '-';
+    *p++ = '0' + year / 1000;
+    *p++ = '0' + year / 100 % 10;
+    *p++ = '0' + year / 10 % 10;
+    *p++ = '0' + year % 10;
+    return p;
+}
+
+#else
+
+// Logs the claim with a fixed-layout receipt. Formatting the dates for display is left to clients.
+void token::log_claim( name claimant, asset claim_quantity, time_type next_last_claim_day, time_type lost_days ) {
+    PRINT("UBI claim: ",claimant," ",claim_quantity," ",next_last_claim_day," ",lost_days,"\n");
+
+    SEND_INLINE_ACTION( *this, ubireceipt, { {get_self(), "active"_n} },
+                        { claimant, claim_quantity, next_last_claim_day, lost_days }
+    );
 }
 
+#endif
+
 } /// namespace eosio
 
-EOSIO_DISPATCH( eosio::token, (create)(issue)(transfer)(open)(close)(retire) )
+EOSIO_DISPATCH( eosio::token, (create)(issue)(transfer)(transfermany)(open)(openmany)(close)(ubireceipt)(retire)(migrate)(maintain)(setelig)(setnotify)(getaccrued)(getliability)(getdormant)(setmetrics)(getmetrics)(compact) )
@@ -18,8 +18,12 @@
 #include <eosiolib/print.hpp>
 #include <eosiolib/transaction.hpp>
 #include <eosiolib/singleton.hpp>
+#include <eosiolib/binary_extension.hpp>
 
+#include "ubi_config.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 /* <-- erase just one slash bar to switch those codes (commented/actual-code)
@@ -28,6 +32,10 @@
 #define PRINT(...)
 //*/
 
+// Define this (e.g. with -DCLAIM_MEMO) to log UBI claims as transfers to self with a descriptive memo,
+//   for wallets that display it, instead of as compact ubireceipt actions. See log_ubi_claims.
+// #define CLAIM_MEMO
+
 namespace eosiosystem {
     class system_contract;
 }
@@ -40,6 +48,9 @@ namespace eosio {
         public:
             using contract::contract;
 
+            // Days since the epoch.
+            typedef uint16_t time_type;
+
             [[eosio::action]]
             void create(name issuer, asset maximum_supply);
 
@@ -52,16 +63,130 @@ namespace eosio {
             [[eosio::action]]
             void transfer( name from, name to, asset quantity, string  memo );
 
+            // One entry of a transfermany() batch.
+            struct payment {
+                name    to;
+                asset   quantity;
+                string  memo;
+            };
+
+            // Pays every entry of "payments" from "from" as if each was a transfer() of its own, except
+            //   that the sender is checked, claims its UBI and is debited only once for the whole batch.
+            // Every recipient is still notified. All payments must be in the same token.
+            [[eosio::action]]
+            void transfermany( name from, const std::vector<payment>& payments );
+
             [[eosio::action]]
             void open( name owner, const symbol& symbol, name ram_payer );
 
             [[eosio::action]]
             void close( name owner, const symbol& symbol );
+
+            // Opens a balance for every owner in "owners", with "sponsor" paying the RAM, and pays each UBI
+            //   account its first claim as open() would. Owners that already have a balance are skipped.
+            // Owners must be sorted by ascending name value, without duplicates, or the action fails. The
+            //   progress of each "wave" is saved per sponsor and symbol, and owners at or below its cursor are
+            //   skipped, so a long list can be split across transactions and any chunk can be retried. A new
+            //   wave number starts over from the beginning.
+            [[eosio::action]]
+            void openmany( name sponsor, const symbol& symbol, uint64_t wave, const std::vector<name>& owners );
+
+            // Receipt of an UBI claim, sent by the contract to itself and to the claimant (unless it opted out
+            //   with setnotify()). Only logs the claim: the claimed quantity has already been added to the
+            //   claimant's balance. The next claim can be done on next_claim_day + 1 (days since the epoch);
+            //   lost_days is the number of days of income that were older than "max_past_claim_days" and
+            //   could not be claimed.
+            [[eosio::action]]
+            void ubireceipt( name claimant, asset quantity, time_type next_claim_day, time_type lost_days );
+
+            // Moves the claim day of each owner from the legacy "extras" table into its "accounts" row.
+            // Owners must be sorted by ascending name value, without duplicates, or the action fails (it is
+            //   the order in which "get_table_by_scope" lists the scopes of the "extras" table). Owners at or
+            //   below the saved cursor are skipped, so a keeper can resume the migration from the cursor after
+            //   any failed or partial chunk.
+            [[eosio::action]]
+            void migrate( const symbol_code& sym, const std::vector<name>& owners );
+
+            enum maintenance_pass : uint8_t {
+                cleanup_pass = 0,   // erases zero-balance rows of accounts that cannot claim UBI, and extras rows
+                                    //   that are orphaned or already superseded by a claim day in "accounts"
+                audit_pass   = 1,   // adds up balances and claim days, to check them against the stat row
+                migrate_pass = 2,   // moves claim days from the "extras" table into the "accounts" rows
+                index_pass   = 3,   // adds the claim days of rows opened before the "claimindex" table existed
+                maintenance_passes
+            };
+
+            // Runs one maintenance pass over the balance rows of "owners" (the scopes listed by
+            //   "get_table_by_scope", sorted by ascending name value without duplicates, or the action fails),
+            //   reading at most about "max_rows" rows so that a keeper can call it continuously without hitting
+            //   the transaction deadline. The cursor of the pass is saved per symbol: owners at or below it are
+            //   skipped, and owners left over when the budget runs out are for the next call. "restart" (or a
+            //   different pass) starts over from the first owner. Prints the progress of the pass as JSON.
+            [[eosio::action]]
+            void maintain( const symbol_code& sym, uint8_t pass, bool restart, const std::vector<name>& owners, uint32_t max_rows );
+
+            // Puts "account" on the allow list (status 1) or deny list (status 2) read by the allowlisted
+            //   and not_denylisted eligibility policies, or takes it off both (status 0).
+            [[eosio::action]]
+            void setelig( name account, uint8_t status );
+
+            enum notify_mode : uint8_t {
+                notify_all      = 0,    // of every transfer sent or received, as eosio.token does (the default)
+                notify_incoming = 1,    // only of transfers received, and of UBI claims
+                notify_none     = 2,    // of no transfer at all
+                notify_modes
+            };
+
+            // Sets which transfers of a token "account" is notified of. Accounts that run no code on
+            //   notifications, such as exchange hot wallets and settlement accounts, save the dispatch of a
+            //   notification on every transfer they send or receive.
+            [[eosio::action]]
+            void setnotify( name account, const symbol_code& sym, uint8_t mode );
+
+            // One (owner, symbol) pair of a getaccrued() query.
+            struct balance_query {
+                name         owner;
+                symbol_code  sym;
+            };
+
+            // Prints, as a JSON array, the accrued balance (see get_accrued_balance()) of every pair of
+            //   "queries". Needs no authorization and writes nothing, so wallets can run it as a read-only
+            //   or dry-run transaction to show up-to-date balances without claiming anything.
+            [[eosio::action]]
+            void getaccrued( const std::vector<balance_query>& queries );
+
+            // Prints, as JSON, the UBI liability of a token (see get_ubi_liability()). Writes nothing.
+            [[eosio::action]]
+            void getliability( const symbol_code& sym );
+
+            // Prints, as a JSON array, up to "limit" UBI accounts of a token whose claim day is at least "from_day"
+            //   and less than "to_day" (see get_dormant()), those that have claimed least recently first.
+            //   Writes nothing.
+            [[eosio::action]]
+            void getdormant( const symbol_code& sym, time_type from_day, time_type to_day, uint32_t limit );
+
+            // Keeps per-day counters of a token (see daily_metrics) for the last "days" days, or stops keeping
+            //   them when "days" is 0. The counters already kept are cleared. Off by default: when on, every
+            //   action that changes a counter reads and writes the row of the day, which all of them share.
+            [[eosio::action]]
+            void setmetrics( const symbol_code& sym, time_type days );
+
+            // Prints, as a JSON array, the counters of the days kept by setmetrics() (see get_metrics()).
+            //   Writes nothing.
+            [[eosio::action]]
+            void getmetrics( const symbol_code& sym );
+
+            // Folds what the supply shards of a token have minted into its stat row, and shares the rest of the
+            //   max_supply out again as new shard allowances. Also rebuilds the filter of the accounts that set
+            //   a notification mode (see notify()), dropping those that went back to the default. Meant to be
+            //   run periodically by a keeper, and once after upgrading a token created before the shards existed.
+            [[eosio::action]]
+            void compact( const symbol_code& sym );
     
             static asset get_supply( name token_contract_account, symbol_code sym_code ) {
                 stats statstable( token_contract_account, sym_code.raw() );
                 const auto& st = statstable.get( sym_code.raw() );
-                return st.supply;
+                return fold_shards( token_contract_account, st ).supply;
             }
 
             static asset get_balance( name token_contract_account, name owner, symbol_code sym_code ) {
@@ -70,18 +195,212 @@ namespace eosio {
                 return ac.balance;
             }
 
-        private:
-            typedef uint16_t time_type;
+            // What a claim made on "today" pays to an UBI account whose income has been claimed up to
+            //   "last_claim_day", when at most "available_amount" can be minted. Nothing is paid when quantity
+            //   is zero. The schedule defaults to the one the contract is built with; tools that project other
+            //   schedules (native/tools/ubi_simulator.cpp) pass their own "days_in_advance" and "max_past_days".
+            struct claim_result {
+                asset      quantity;
+                time_type  next_claim_day;
+                time_type  lost_days;
+            };
+
+            static claim_result compute_claim( time_type last_claim_day, time_type today, const symbol& sym, int64_t available_amount,
+                                               int64_t days_in_advance = claim_days, int64_t max_past_days = max_past_claim_days ) {
+                claim_result claim{ asset{0, sym}, last_claim_day, 0 };
+                if (last_claim_day >= today)
+                    return claim;
+
+                // The UBI grants 1 token per day per account. 
+                // Users will automatically issue their own money as a side-effect of giving money to others.
+
+                // Compute the claim amount relative to days elapsed since the last claim, excluding today's pay.
+                // If you claimed yesterday, this is zero.
+                int64_t claim_amount = today - last_claim_day - 1;
+                // The limit for claiming accumulated past income is 360 days/coins. Unclaimed tokens past that
+                //   one year maximum of accumulation are lost.
+                if (claim_amount > max_past_days) {
+                    claim.lost_days = claim_amount - max_past_days;
+                    claim_amount = max_past_days;
+                }
+                // You always claim for the next 30 days, counting today. This is the advance-payment part
+                //   of the UBI claim.
+                claim_amount += days_in_advance;
+
+                int64_t precision_multiplier = get_precision_multiplier(sym);
+                claim.quantity.set_amount( claim_amount * precision_multiplier );
+
+                // Respect the max_supply limit for UBI issuance. Only whole days are paid: the claim day moves
+                //   by whole days, and the part of a day paid on top would be paid again by the next claim.
+                if (claim.quantity.amount > available_amount)
+                    claim.quantity.set_amount(available_amount - available_amount % precision_multiplier);
+
+                // Move the claim date window proportional to the amount of days of income we claimed (and
+                //   also account for days of income that have been forever lost).
+                time_type last_claim_day_delta = claim.lost_days + (claim.quantity.amount / precision_multiplier);
+                claim.next_claim_day = last_claim_day + last_claim_day_delta;
+                return claim;
+            }
+
+            struct accrued_balance {
+                asset      balance;     // balance held right now
+                asset      claimable;   // UBI the owner would be paid by a claim made right now
+                time_type  lost_days;   // days of income that are too old to be claimed anymore
+            };
+
+            // The balance of "owner" as it would be right after an UBI claim, without claiming anything.
+            // Owners without a balance row have a zero balance (and claim their UBI when they open one).
+            static accrued_balance get_accrued_balance( name token_contract_account, name owner, symbol_code sym_code ) {
+                stats statstable( token_contract_account, sym_code.raw() );
+                const auto& st = statstable.get( sym_code.raw(), "symbol does not exist" );
+                accrued_balance result{ asset{0, st.supply.symbol}, asset{0, st.supply.symbol}, 0 };
+
+                accounts acnts( token_contract_account, owner.value );
+                auto it = acnts.find( sym_code.raw() );
+                if (it == acnts.end())
+                    return result;
+                result.balance = it->balance;
+
+                if (owner == token_contract_account || !ubi_eligibility::check( token_contract_account, owner ))
+                    return result;
+
+                time_type last_claim_day = get_first_claim_day();
+                if (it->last_claim_day.has_value()) {
+                    last_claim_day = it->last_claim_day.value();
+                } else {
+                    extras xtrs( token_contract_account, owner.value );
+                    auto itx = xtrs.find( sym_code.raw() );
+                    if (itx != xtrs.end())
+                        last_claim_day = itx->last_claim_day;
+                }
+
+                supply_shards shards( token_contract_account, sym_code.raw() );
+                auto shard = shards.find( shard_of( owner ) );
+                const int64_t allowance = shard != shards.end() ? shard->allowance.amount : 0;
+                const claim_result claim = compute_claim( last_claim_day, get_today(), st.supply.symbol, allowance );
+                if (claim.quantity.amount > 0) {
+                    result.balance += claim.quantity;
+                    result.claimable = claim.quantity;
+                }
+                result.lost_days = claim.lost_days;
+                return result;
+            }
+
+            struct ubi_liability {
+                uint64_t  ubi_accounts;      // balance rows that accrue UBI
+                int64_t   unclaimed_days;    // days of income accrued by those rows and not claimed yet
+                asset     unclaimed;         // what those days are worth
+                asset     projected_supply;  // supply once all of it is claimed, up to max_supply
+            };
+
+            // The UBI that has accrued but has not been minted yet, computed from the stat row alone. It is an
+            //   upper bound: days of income older than "max_past_claim_days" are lost rather than paid when
+            //   claimed. Rows still waiting in the legacy "extras" table are only counted once migrated.
+            static ubi_liability get_ubi_liability( name token_contract_account, symbol_code sym_code ) {
+                stats statstable( token_contract_account, sym_code.raw() );
+                const currency_stats st = fold_shards( token_contract_account, statstable.get( sym_code.raw(), "symbol does not exist" ) );
+
+                ubi_liability result{ st.ubi_accounts.value_or(), 0, asset{0, st.supply.symbol}, st.supply };
+                // Claiming today moves a row's claim day up to today - 1 + claim_days.
+                result.unclaimed_days = int64_t(result.ubi_accounts) * (get_today() - 1 + claim_days) - int64_t(st.claim_day_sum.value_or());
+                result.unclaimed.set_amount( result.unclaimed_days * get_precision_multiplier(st.supply.symbol) );
+                result.projected_supply += result.unclaimed;
+                if (result.projected_supply > st.max_supply)
+                    result.projected_supply = st.max_supply;
+                return result;
+            }
+
+            struct dormant_account {
+                name       owner;
+                time_type  last_claim_day;   // income has been claimed up to this day
+            };
+
+            // Up to "limit" UBI accounts of a token whose claim day is at least "from_day" and less than "to_day",
+            //   in ascending order of claim day (then name). Accounts whose claim day is today - max_past_claim_days
+            //   or older lose a day of income for every day they don't claim. Empty unless the contract is built
+            //   with index_claim_days.
+            static std::vector<dormant_account> get_dormant( name token_contract_account, symbol_code sym_code,
+                                                             time_type from_day, time_type to_day, uint32_t limit ) {
+                std::vector<dormant_account> result;
+                claim_index index( token_contract_account, sym_code.raw() );
+                auto by_day = index.get_index<"byclaimday"_n>();
+                for (auto it = by_day.lower_bound( from_day ); it != by_day.end() && result.size() < limit; ++it) {
+                    if (it->last_claim_day >= to_day)
+                        break;
+                    result.push_back( dormant_account{ it->owner, it->last_claim_day } );
+                }
+                return result;
+            }
+
+            // What happened to a token on one day.
+            struct daily_metrics {
+                time_type  day = 0;
+                uint64_t   transfers = 0;        // payments made by transfer() and transfermany(), not counting transfers to self
+                int64_t    transfer_volume = 0;  // amount they moved
+                uint64_t   claims = 0;           // UBI claims paid
+                int64_t    minted = 0;           // amount paid by those claims
+                uint64_t   lost_days = 0;        // days of income lost by claims for being older than max_past_claim_days
+                uint64_t   new_holders = 0;      // balance rows opened
+                uint64_t   closed_holders = 0;   // balance rows closed
+
+                bool empty()const {
+                    return transfers == 0 && claims == 0 && lost_days == 0 && new_holders == 0 && closed_holders == 0;
+                }
+            };
+
+            static constexpr time_type max_metrics_days = 366;
 
+            // The counters of the last "days" days set by setmetrics(), oldest first. Days without activity are
+            //   left out.
+            static std::vector<daily_metrics> get_metrics( name token_contract_account, symbol_code sym_code ) {
+                std::vector<daily_metrics> result;
+                stats statstable( token_contract_account, sym_code.raw() );
+                const auto& st = statstable.get( sym_code.raw(), "symbol does not exist" );
+                const time_type days = st.metrics_days.value_or();
+                if (days == 0)
+                    return result;
+
+                // The ring buffer holds one row per slot; a row still holding a day that has gone out of the
+                //   window is rewritten by the next activity on its slot.
+                const time_type today = get_today();
+                metrics_buckets buckets( token_contract_account, sym_code.raw() );
+                for (const auto& b : buckets) {
+                    if (b.counters.day <= today && today - b.counters.day < days && !b.counters.empty())
+                        result.push_back( b.counters );
+                }
+                std::sort( result.begin(), result.end(), []( const daily_metrics& a, const daily_metrics& b ) {
+                    return a.day < b.day;
+                });
+                return result;
+            }
+
+        private:
+            // The balance stays a full asset so that the row is still readable by every client that
+            //   knows the eosio.token "accounts" table (e.g. "cleos get currency balance").
+            // The day up to which UBI has been claimed is only stored in the rows of accounts that can
+            //   claim UBI, so the rows of everyone else are exactly as large as in eosio.token. Rows
+            //   written before the "extras" table was merged into this one get it when migrated.
             struct [[eosio::table]] account {
-                asset     balance;
+                asset                        balance;
+                binary_extension<time_type>  last_claim_day;
+
                 uint64_t primary_key()const { return balance.symbol.code().raw(); }
             };
 
+            // ubi_accounts counts the balance rows that carry a claim day and claim_day_sum adds up their claim
+            //   days, so that the outstanding UBI can be read from this row and the supply shards. See
+            //   count_claim_days(). The supply minted by claims since the last compact() (or retire()) is in the
+            //   shards, not in "supply".
+            // metrics_days is the number of days of metrics kept, see setmetrics(). notify_filter is a Bloom filter
+            //   of the accounts that have set a notification mode, see notify().
             struct [[eosio::table]] currency_stats {
-                asset    supply;
-                asset    max_supply;
-                name     issuer;
+                asset                                   supply;
+                asset                                   max_supply;
+                name                                    issuer;
+                binary_extension<uint64_t>              ubi_accounts;
+                binary_extension<uint64_t>              claim_day_sum;
+                binary_extension<time_type>             metrics_days;
+                binary_extension<std::vector<uint8_t>>  notify_filter;
 
                 uint64_t primary_key()const { return supply.symbol.code().raw(); }
             };
@@ -90,12 +409,107 @@ namespace eosio {
             typedef eosio::multi_index< "stat"_n, currency_stats > stats;
 
             void sub_balance( name owner, asset value );
-            void add_balance( name owner, asset value, name ram_payer );
+            void sub_balance( name owner, accounts& from_acnts, const account& from, asset value );
+            // Returns true if it created a balance row that carries a claim day.
+            bool add_balance( name owner, asset value, name ram_payer, daily_metrics& metrics );
+
+            // Updates the UBI liability aggregates when balance rows start or stop carrying a claim day, or
+            //   when their claim day moves. Every change to a claim day must go through one of these.
+            static void count_claim_days( currency_stats& s, int64_t accounts_delta, int64_t claim_day_delta ) {
+                s.ubi_accounts.emplace( s.ubi_accounts.value_or() + accounts_delta );
+                s.claim_day_sum.emplace( s.claim_day_sum.value_or() + claim_day_delta );
+            }
+
+            void track_claim_days( stats& statstable, const currency_stats& st, int64_t accounts_delta, int64_t claim_day_delta );
+            void track_claim_days( name owner, const symbol& sym, int64_t accounts_delta, int64_t claim_day_delta );
+
+            // Part of the supply of a token, scoped by symbol code. Claims mint from the shard of the claimant
+            //   only, up to its allowance, and only write that row, so that the claims of unrelated accounts do
+            //   not conflict on the stat row. compact() folds the shards into the stat row and renews their
+            //   allowances. The supply stays capped: the stat row supply, plus everything minted by and still
+            //   allowed to the shards, never exceeds max_supply.
+            // The changes of the liability aggregates made by the accounts of a shard are kept here as well.
+            struct [[eosio::table]] supply_shard {
+                uint64_t  id;
+                asset     minted;
+                asset     allowance;
+                int64_t   ubi_accounts = 0;
+                int64_t   claim_day_sum = 0;
+
+                uint64_t primary_key()const { return id; }
+            };
+
+            typedef eosio::multi_index< "supplyshard"_n, supply_shard > supply_shards;
+
+            // The splitmix64 finalizer: short names have all their low bits clear, so every bit of the name has
+            //   to be mixed into the ones a shard or a filter bit is taken from.
+            static uint64_t hash_name( name n ) {
+                uint64_t x = n.value;
+                x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+                x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+                return x ^ (x >> 31);
+            }
+
+            static uint64_t shard_of( name owner ) {
+                return hash_name( owner ) % supply_shard_count;
+            }
+
+            // The shard "id" of a token. A token created before the shards existed, or a schedule with more of
+            //   them, has none until compact() creates them with their allowances.
+            const supply_shard& get_shard( supply_shards& shards, uint64_t id );
+
+            void renew_shards( const symbol& sym, int64_t headroom );
 
-            // Unfortunately, we need to waste a ton of space to store an extra 16 bits per user account
-            //    to conform to the interface expected by eosio.token.
-            // As with the "account" struct, the scope is recycled as the token holder, and the primary
-            //    key of our structure is the token symbol code.
+            // "st" with the supply minted by the shards and their liability aggregates added in.
+            static currency_stats fold_shards( name token_contract_account, const currency_stats& st ) {
+                currency_stats folded = st;
+                supply_shards shards( token_contract_account, st.supply.symbol.code().raw() );
+                for (const auto& shard : shards) {
+                    folded.supply += shard.minted;
+                    count_claim_days( folded, shard.ubi_accounts, shard.claim_day_sum );
+                }
+                return folded;
+            }
+
+            // The claim day of every balance row that carries one, scoped by symbol code and ordered by claim day
+            //   in the "byclaimday" index. Kept in step with the balance rows by index_claim_day() when the
+            //   contract is built with index_claim_days. Rows opened before the table existed are added by their
+            //   next claim, billed to the account that authorized it, or by the index pass of maintain(), billed
+            //   to the contract.
+            struct [[eosio::table]] claim_index_row {
+                name       owner;
+                time_type  last_claim_day;
+
+                uint64_t primary_key()const { return owner.value; }
+                uint64_t by_claim_day()const { return last_claim_day; }
+            };
+
+            typedef eosio::multi_index< "claimindex"_n, claim_index_row,
+                indexed_by< "byclaimday"_n, const_mem_fun<claim_index_row, uint64_t, &claim_index_row::by_claim_day> >
+            > claim_index;
+
+            // Sets the claim day of "owner" in the "claimindex" table, adding its row (paid by "payer") if needed,
+            //   or takes the owner out of the table when "claim_day" is 0. Every change to the claim day of a
+            //   balance row must go through here. Returns true if the table changed.
+            bool index_claim_day( name owner, const symbol_code& sym, time_type claim_day, name payer );
+
+            // The metrics of a token, scoped by symbol code: a ring buffer of one row per day, the row of a day
+            //   being slot day % metrics_days. A row is reset when a new day first writes its slot.
+            struct [[eosio::table]] metrics_bucket {
+                uint64_t       slot;
+                daily_metrics  counters;
+
+                uint64_t primary_key()const { return slot; }
+            };
+
+            typedef eosio::multi_index< "metrics"_n, metrics_bucket > metrics_buckets;
+
+            // Adds "metrics" to the counters of today, if the token keeps metrics. Each action gathers its
+            //   changes and records them once, so that it writes the row of the day at most once.
+            void record_metrics( const currency_stats& st, const daily_metrics& metrics );
+
+            // Legacy table that used to hold the last claim day of each UBI account, in a second row next
+            //    to the "account" one. It is only read to migrate its rows into the "accounts" table.
             struct [[eosio::table]] extra {
                 uint64_t  symbol_code_raw;
                 time_type last_claim_day;
@@ -105,24 +519,157 @@ namespace eosio {
 
             typedef eosio::multi_index< "extras"_n, extra > extras;
 
-            void create_extra_record( name owner, name ram_payer, uint64_t sym_code_raw );
+            // Progress of the "extras" table migration, scoped by symbol code.
+            struct [[eosio::table]] migration_state {
+                name      cursor;
+                uint64_t  migrated = 0;
+            };
+
+            typedef eosio::singleton< "migration"_n, migration_state > migration_singleton;
+
+            // Progress of the current maintain() pass, scoped by symbol code.
+            struct [[eosio::table]] maintenance_state {
+                uint8_t   pass = cleanup_pass;
+                name      cursor;
+                uint64_t  owners = 0;          // owners visited
+                uint64_t  changed = 0;         // rows erased or rewritten
+                int64_t   balance_sum = 0;     // audit pass: sum of the balances visited
+                uint64_t  ubi_accounts = 0;    // audit pass: rows visited that carry a claim day
+                uint64_t  claim_day_sum = 0;   // audit pass: sum of those claim days
+            };
+
+            typedef eosio::singleton< "maintenance"_n, maintenance_state > maintenance_singleton;
+
+            // Changes to the liability aggregates accumulated over a batch of rows, per supply shard of their
+            //   owners, so that each shard is written once at the end of the batch and the stat row not at all.
+            struct claim_day_changes {
+                struct shard_change {
+                    uint64_t  id;
+                    int64_t   accounts;
+                    int64_t   days;
+                };
+                std::vector<shard_change>  shards;
+
+                void add( name owner, int64_t accounts_delta, int64_t claim_day_delta ) {
+                    const uint64_t id = shard_of( owner );
+                    for (auto& change : shards) {
+                        if (change.id == id) {
+                            change.accounts += accounts_delta;
+                            change.days     += claim_day_delta;
+                            return;
+                        }
+                    }
+                    shards.push_back( shard_change{ id, accounts_delta, claim_day_delta } );
+                }
+            };
+
+            void track_claim_days( const symbol_code& sym, const claim_day_changes& changes );
+
+            bool migrate_owner( name owner, const symbol_code& sym, claim_day_changes& changes );
+
+            // One maintenance pass applied to the rows of one owner. Returns the number of rows it read or wrote.
+            typedef uint32_t (token::*maintenance_step)( name owner, const symbol_code& sym, maintenance_state& state, claim_day_changes& changes );
+
+            uint32_t cleanup_step( name owner, const symbol_code& sym, maintenance_state& state, claim_day_changes& changes );
+            uint32_t audit_step( name owner, const symbol_code& sym, maintenance_state& state, claim_day_changes& changes );
+            uint32_t migrate_step( name owner, const symbol_code& sym, maintenance_state& state, claim_day_changes& changes );
+            uint32_t index_step( name owner, const symbol_code& sym, maintenance_state& state, claim_day_changes& changes );
+
+            // Accounts that are not notified of every transfer of a token (see setnotify()), scoped by symbol
+            //   code. Accounts without a row are notified as in eosio.token.
+            struct [[eosio::table]] notify_pref {
+                name     account;
+                uint8_t  mode;
+
+                uint64_t primary_key()const { return account.value; }
+            };
+
+            typedef eosio::multi_index< "notifyprefs"_n, notify_pref > notify_prefs;
+
+            // Bytes of the stat row filter of "count" accounts of "notifyprefs": about 16 bits per account, which
+            //   keeps the false positive rate of their two bits near 1.5%, as a power of two between 8 and 256
+            //   bytes, so that the filter only weighs on the stat row as much as the accounts it holds.
+            static uint32_t notify_filter_bytes( uint64_t count ) {
+                uint32_t bytes = 8;
+                while (bytes < 256 && bytes * 8 < count * 16)
+                    bytes *= 2;
+                return bytes;
+            }
+
+            static uint32_t notify_filter_bit( name account, int i, size_t filter_bytes ) {
+                return uint32_t( hash_name( account ) >> (32 * i) ) % (filter_bytes * 8);
+            }
+
+            // Notifies "account" of a transfer it receives ("incoming") or sends, unless it opted out. The
+            //   "notifyprefs" table is only read for accounts that pass the filter of the stat row, so that
+            //   everyone else costs a transfer nothing more than in eosio.token. setnotify() only adds accounts
+            //   to the filter: compact() rebuilds it from "notifyprefs", sized for the accounts left there.
+            void notify( const currency_stats& st, name account, bool incoming );
+
+            // Progress of the current openmany() wave of a sponsor, scoped by sponsor.
+            struct [[eosio::table]] onboarding {
+                symbol_code  sym;
+                uint64_t     wave;
+                name         cursor;
+                uint64_t     opened = 0;
 
-            void try_ubi_claim( name from, const symbol& sym, name payer, stats& statstable, const currency_stats& st );
+                uint64_t primary_key()const { return sym.raw(); }
+            };
+
+            typedef eosio::multi_index< "onboarding"_n, onboarding > onboardings;
+
+            // The claim day a new UBI row starts from.
+            static time_type get_first_claim_day() {
+                if (!unbounded_UBI_account_creation)
+                    return config::first_claim_day;
+                // if we are in an everything-goes, free EOSIO public chain, then
+                //   open() needs to add a two-day grace period for any UBI claims
+                //   to mitigate money printing by repeated account creation/destruction.
+                // The grace period runs from the day the row is opened: a row that started from the
+                //   first claim day would be paid max_past_claim_days again after every close().
+                return std::max<time_type>( config::first_claim_day + 2, get_today() + 1 );
+            }
+
+            time_type migrate_extra_record( name owner, accounts& acnts, const account& acnt, name payer );
 
-            string claim_memo( name claimant, asset claim_quantity, time_type next_last_claim_day, time_type lost_days );
+            // "payer" pays for the claim day added to a row that has not been migrated yet, and must have
+            //   authorized the action. A row "opened" by this action is counted in the liability aggregates
+            //   here, with the same write to the supply shard as the claim.
+            void try_ubi_claim( name from, accounts& from_acnts, const account& from_acnt, const symbol& sym, name payer,
+                                daily_metrics& metrics, bool opened = false );
+
+            void log_claim( name claimant, asset claim_quantity, time_type next_last_claim_day, time_type lost_days );
+
+#ifdef CLAIM_MEMO
+            static constexpr size_t max_claim_memo_size = 256;
+
+            static size_t claim_memo( char* buf, name claimant, time_type next_last_claim_day );
+#endif
         
+            // create() only accepts precisions that are in the table.
             static int64_t get_precision_multiplier ( const symbol& symbol ) {
-                int64_t precision_multiplier = 1;
-                for (int i=0; i<symbol.precision(); ++i) {
-                    precision_multiplier *= 10;
-                }
-                return precision_multiplier;
+                return ubi_config::precision_multipliers[symbol.precision()];
             }
 
-            static string days_to_string( int64_t days );
+#ifdef CLAIM_MEMO
+            static char* write_name( char* p, name n );
+
+            static char* write_date( char* p, int64_t days );
+#endif
         
             static time_type get_today() { return (time_type)(current_time() / 86400000000); }
 
+            // The UBI schedule this contract is built with. See ubi_config.hpp for what each setting does.
+            typedef ubi_config::UBI_CONFIG config;
+            static_assert( ubi_config::check<config>(), "invalid UBI schedule" );
+
+            static constexpr bool unbounded_UBI_account_creation = config::unbounded_UBI_account_creation;
+            static constexpr int64_t claim_days = config::claim_days;
+            static constexpr int64_t max_past_claim_days = config::max_past_claim_days;
+            static constexpr bool log_ubi_claims = config::log_ubi_claims;
+            static constexpr uint32_t supply_shard_count = config::supply_shard_count;
+            static constexpr bool index_claim_days = config::index_claim_days;
+
             // Before deploying this contract to your blockchain, make sure this function is doing what you want.
             // If you don't have KYC or any sort of ID check or de-duplication mechanism, this just returns true.
             // Otherwise, you will want to check whether an account likely belongs to an uniquified person or not.
@@ -130,35 +677,28 @@ namespace eosio {
             //   point in the future (and have that authority randomly rescinded and granted again an unlimited
             //   number of times, at any time) and the contract will continue to work normally. Users who are
             //   later KYC'd will be able to claim up to "max_past_claim_days" days of back pay.
-            bool can_claim_UBI( name claimant ) {
-                // for HEART token UBI username MUST end with ".jc"
+            // The policy is a combination of the ones in eligibility.hpp, e.g. to also let the contract allow
+            //   and deny accounts by hand:
+            //     eligibility::all_of< eligibility::not_denylisted,
+            //                          eligibility::any_of< eligibility::allowlisted, eligibility::name_suffix<".jc"_n.value> > >
+            // or to defer to a KYC registry contract:
+            //     eligibility::kyc_registry< "kycregistry"_n, "verified"_n >
+            // The policy of each schedule is set in ubi_config.hpp.
+            typedef config::eligibility_policy ubi_eligibility;
 
-                string str = claimant.to_string();
-                int len = str.size();
-                if (str[len-3] != '.') return false;
-                if (str[len-2] != 'j') return false;
-                if (str[len-1] != 'c') return false;
-                return true;
+            bool can_claim_UBI( name claimant ) {
+                return ubi_eligibility::check( _self, claimant );
             }
-        
-            // Set this to true if your blockchain allows an user to freely create and destroy the types of accounts
-            //   that will be authorized to claim UBI.
-            // This will ensure that newly created token accounts have a two-day grace period before they can claim
-            //   any UBI (that is measured as whole days, so if you create an account at 11:59:59 PM, you have to wait
-            //   one day plus one second, which is why we require two whole days). That's a bit inconvenient for the
-            //   user, but it is necessary to avoid completely unbounded, zero-cost money printing.
-            static const bool unbounded_UBI_account_creation = false; 
-            
-            // When UBI can be claimed, claim this amount of days. "1" means today's income only, and from 2 and
-            //   onwards you are granting advance payments for future days.
-            // For non-KYC, unbounded-account-creation EOSIO public deployments, you want to set this to 1.
-            // For a proper KYC chain where users can't continuously create and destroy their KYC accounts to
-            //   reset them, you can set this to 30 to grant users an entire month's worth of UBI at a time.
-            // A value of zero (or less) is not supported by the current code.
-            static const int64_t claim_days = 1;
-
-            // Unclaimed UBI accumulates to this maximum days.
-            static const int64_t max_past_claim_days = 36000;
+
+        public:
+            // The tables the native tools read directly, or seed with the rows an older version of the contract
+            //   left (see token_driver::seed_legacy()).
+            typedef accounts         balance_table;
+            typedef extras           legacy_extras_table;
+            typedef stats            stat_table;
+            typedef supply_shards    supply_shard_table;
+            typedef claim_index      claim_index_table;
+            typedef metrics_buckets  metrics_table;
         };
 
 } /// namespace eosio
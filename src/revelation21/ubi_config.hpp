@@ -0,0 +1,122 @@
+/**
+ * UBI schedules the token contract can be built with.
+ *
+ * Each schedule is a struct of compile-time constants (and the eligibility policy type), and the
+ *   contract is built for the one named by UBI_CONFIG, e.g. "eosio-cpp -DUBI_CONFIG=kyc_monthly".
+ *   The default is the HEART schedule. To add a token, add a struct here with every member of
+ *   "heart" and build with its name.
+ */
+#pragma once
+
+#include "eligibility.hpp"
+
+#ifndef UBI_CONFIG
+#define UBI_CONFIG heart
+#endif
+
+namespace eosio { namespace ubi_config {
+
+    // The HEART token on Telos.
+    struct heart {
+        // Days since the epoch of the first day of income of every account.
+        static constexpr uint16_t first_claim_day = 18047; // 30 de mayo
+        // 18016 - 29 de abril
+        // 18017 - 30 de abril
+        // 18018 - 1 de mayo
+        // 18019 - 2 de mayo
+        // 18047 - 30 de mayo
+
+        // Set this to true if your blockchain allows an user to freely create and destroy the types of accounts
+        //   that will be authorized to claim UBI.
+        // This will ensure that newly created token accounts have a two-day grace period before they can claim
+        //   any UBI (that is measured as whole days, so if you create an account at 11:59:59 PM, you have to wait
+        //   one day plus one second, which is why we require two whole days). That's a bit inconvenient for the
+        //   user, but it is necessary to avoid completely unbounded, zero-cost money printing.
+        static constexpr bool unbounded_UBI_account_creation = false;
+
+        // When UBI can be claimed, claim this amount of days. "1" means today's income only, and from 2 and
+        //   onwards you are granting advance payments for future days.
+        // For non-KYC, unbounded-account-creation EOSIO public deployments, you want to set this to 1.
+        // For a proper KYC chain where users can't continuously create and destroy their KYC accounts to
+        //   reset them, you can set this to 30 to grant users an entire month's worth of UBI at a time.
+        // A value of zero (or less) is not supported by the current code.
+        static constexpr int64_t claim_days = 1;
+
+        // Unclaimed UBI accumulates to this maximum days.
+        static constexpr int64_t max_past_claim_days = 36000;
+
+        // UBI claims are minted directly into the claimant's balance and leave no action of their own in
+        //   the chain history. Set this to true to also log every claim as an inline ubireceipt action
+        //   (or, when built with CLAIM_MEMO, as a transfer-to-self carrying a descriptive memo, for
+        //   wallets that only look at transfer actions). This costs one extra inline action per claim.
+        static constexpr bool log_ubi_claims = false;
+
+        // Number of supply shards: claims mint from the shard their account hashes to, so claims of accounts
+        //   in different shards never write the same row. See token::compact().
+        static constexpr uint32_t supply_shard_count = 16;
+
+        // Keep every UBI account in the "claimindex" table ordered by claim day, so that bots can find the
+        //   accounts that have not claimed for the longest in log time instead of reading every scope. Costs
+        //   an index row per UBI account and one more write when a claim moves the claim day. See
+        //   token::get_dormant().
+        // The index row (about 250 bytes of billable RAM) costs more than the balance row it indexes, so it
+        //   doubles the RAM of an UBI holder. It is billed to whoever opens or pays for the balance row, or
+        //   claims with it, but the rows that migrate() and the index pass of maintain() add for holders
+        //   that have not claimed since are billed to the contract. Off for HEART, to keep the RAM of its
+        //   holders down: its claim days can be looked at offline instead (see native/tools/table_snapshot.cpp).
+        static constexpr bool index_claim_days = false;
+
+        // Who can claim UBI, see token::can_claim_UBI(). For HEART token UBI username MUST end with ".jc".
+        typedef eligibility::name_suffix<".jc"_n.value> eligibility_policy;
+    };
+
+    // A KYC chain: accounts are allowed by hand (or by a KYC process holding the contract's authority),
+    //   and are paid a month in advance, with up to a year of back pay.
+    struct kyc_monthly {
+        static constexpr uint16_t first_claim_day = 18047;
+        static constexpr bool     unbounded_UBI_account_creation = false;
+        static constexpr int64_t  claim_days = 30;
+        static constexpr int64_t  max_past_claim_days = 360;
+        static constexpr bool     log_ubi_claims = true;
+        static constexpr uint32_t supply_shard_count = 4;
+        static constexpr bool     index_claim_days = true;
+
+        typedef eligibility::allowlisted eligibility_policy;
+    };
+
+    // A public chain with free account creation: every account that has not been denied can claim, one
+    //   day at a time, after the two-day grace period.
+    struct open_chain {
+        static constexpr uint16_t first_claim_day = 18047;
+        static constexpr bool     unbounded_UBI_account_creation = true;
+        static constexpr int64_t  claim_days = 1;
+        static constexpr int64_t  max_past_claim_days = 360;
+        static constexpr bool     log_ubi_claims = false;
+        static constexpr uint32_t supply_shard_count = 64;
+        static constexpr bool     index_claim_days = false;
+
+        typedef eligibility::not_denylisted eligibility_policy;
+    };
+
+    // 10^precision for every precision an asset can have.
+    constexpr int64_t precision_multipliers[] = {
+        1ll, 10ll, 100ll, 1000ll, 10000ll, 100000ll, 1000000ll, 10000000ll, 100000000ll, 1000000000ll,
+        10000000000ll, 100000000000ll, 1000000000000ll, 10000000000000ll, 100000000000000ll,
+        1000000000000000ll, 10000000000000000ll, 100000000000000000ll, 1000000000000000000ll
+    };
+
+    constexpr uint8_t max_precision = sizeof(precision_multipliers) / sizeof(precision_multipliers[0]) - 1;
+
+    // Compile-time checks of a schedule against what the claim arithmetic supports.
+    template <typename Config>
+    constexpr bool check() {
+        static_assert( Config::claim_days >= 1, "claim_days must be at least 1" );
+        static_assert( Config::max_past_claim_days >= 0, "max_past_claim_days cannot be negative" );
+        // Claim days, lost days and the claim day itself are 16-bit day counts.
+        static_assert( Config::max_past_claim_days + Config::claim_days <= 0xFFFF, "too many claimable days" );
+        static_assert( Config::first_claim_day + 2 <= 0xFFFF, "first_claim_day out of range" );
+        static_assert( Config::supply_shard_count >= 1, "at least one supply shard is needed" );
+        return true;
+    }
+
+}} /// namespace eosio::ubi_config